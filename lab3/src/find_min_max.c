@@ -1,7 +1,17 @@
 #include "find_min_max.h"
 #include <limits.h>
+#include <stddef.h>
+#include <string.h>
 
-struct MinMax GetMinMax(int *array, unsigned int begin, unsigned int end) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MIN_MAX_X86 1
+#endif
+
+typedef struct MinMax (*MinMaxFn)(int *array, unsigned int begin, unsigned int end);
+
+// Эталонная скалярная реализация
+struct MinMax GetMinMaxScalar(int *array, unsigned int begin, unsigned int end) {
     struct MinMax min_max;
     min_max.min = INT_MAX;
     min_max.max = INT_MIN;
@@ -17,4 +27,172 @@ struct MinMax GetMinMax(int *array, unsigned int begin, unsigned int end) {
     }
 
     return min_max;
-}
\ No newline at end of file
+}
+
+#ifdef MIN_MAX_X86
+
+// Горизонтальная свертка 128-битных регистров в одно значение
+__attribute__((target("sse4.1")))
+static struct MinMax ReduceSSE41(__m128i vmin, __m128i vmax) {
+    vmin = _mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmin = _mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+    vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    struct MinMax min_max;
+    min_max.min = _mm_cvtsi128_si32(vmin);
+    min_max.max = _mm_cvtsi128_si32(vmax);
+    return min_max;
+}
+
+// Хвост, не кратный ширине вектора, досчитывается скалярно
+static struct MinMax MergeTail(struct MinMax min_max, int *array,
+                               unsigned int begin, unsigned int end) {
+    MergeMinMax(&min_max, GetMinMaxScalar(array, begin, end));
+    return min_max;
+}
+
+__attribute__((target("sse4.1")))
+static struct MinMax GetMinMaxSSE41(int *array, unsigned int begin, unsigned int end) {
+    __m128i vmin0 = _mm_set1_epi32(INT_MAX), vmin1 = vmin0;
+    __m128i vmax0 = _mm_set1_epi32(INT_MIN), vmax1 = vmax0;
+    unsigned int i = begin;
+
+    // Два независимых аккумулятора, чтобы не упираться в латентность min/max
+    for (; end - i >= 8; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(array + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(array + i + 4));
+        vmin0 = _mm_min_epi32(vmin0, a);
+        vmax0 = _mm_max_epi32(vmax0, a);
+        vmin1 = _mm_min_epi32(vmin1, b);
+        vmax1 = _mm_max_epi32(vmax1, b);
+    }
+
+    struct MinMax min_max = ReduceSSE41(_mm_min_epi32(vmin0, vmin1),
+                                        _mm_max_epi32(vmax0, vmax1));
+    return MergeTail(min_max, array, i, end);
+}
+
+__attribute__((target("avx2")))
+static struct MinMax GetMinMaxAVX2(int *array, unsigned int begin, unsigned int end) {
+    __m256i vmin0 = _mm256_set1_epi32(INT_MAX), vmin1 = vmin0;
+    __m256i vmax0 = _mm256_set1_epi32(INT_MIN), vmax1 = vmax0;
+    unsigned int i = begin;
+
+    for (; end - i >= 16; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(array + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(array + i + 8));
+        vmin0 = _mm256_min_epi32(vmin0, a);
+        vmax0 = _mm256_max_epi32(vmax0, a);
+        vmin1 = _mm256_min_epi32(vmin1, b);
+        vmax1 = _mm256_max_epi32(vmax1, b);
+    }
+
+    vmin0 = _mm256_min_epi32(vmin0, vmin1);
+    vmax0 = _mm256_max_epi32(vmax0, vmax1);
+    __m128i vmin = _mm_min_epi32(_mm256_castsi256_si128(vmin0),
+                                 _mm256_extracti128_si256(vmin0, 1));
+    __m128i vmax = _mm_max_epi32(_mm256_castsi256_si128(vmax0),
+                                 _mm256_extracti128_si256(vmax0, 1));
+    return MergeTail(ReduceSSE41(vmin, vmax), array, i, end);
+}
+
+__attribute__((target("avx512f")))
+static struct MinMax GetMinMaxAVX512(int *array, unsigned int begin, unsigned int end) {
+    __m512i vmin0 = _mm512_set1_epi32(INT_MAX), vmin1 = vmin0;
+    __m512i vmax0 = _mm512_set1_epi32(INT_MIN), vmax1 = vmax0;
+    unsigned int i = begin;
+
+    for (; end - i >= 32; i += 32) {
+        __m512i a = _mm512_loadu_si512((const void *)(array + i));
+        __m512i b = _mm512_loadu_si512((const void *)(array + i + 16));
+        vmin0 = _mm512_min_epi32(vmin0, a);
+        vmax0 = _mm512_max_epi32(vmax0, a);
+        vmin1 = _mm512_min_epi32(vmin1, b);
+        vmax1 = _mm512_max_epi32(vmax1, b);
+    }
+
+    // Остаток до 16 элементов обрабатывается маскированной загрузкой
+    if (end - i >= 16) {
+        __m512i a = _mm512_loadu_si512((const void *)(array + i));
+        vmin0 = _mm512_min_epi32(vmin0, a);
+        vmax0 = _mm512_max_epi32(vmax0, a);
+        i += 16;
+    }
+    if (i < end) {
+        __mmask16 mask = (__mmask16)((1u << (end - i)) - 1);
+        vmin0 = _mm512_mask_min_epi32(vmin0, mask, vmin0,
+                                      _mm512_maskz_loadu_epi32(mask, array + i));
+        vmax0 = _mm512_mask_max_epi32(vmax0, mask, vmax0,
+                                      _mm512_maskz_loadu_epi32(mask, array + i));
+        i = end;
+    }
+
+    struct MinMax min_max;
+    min_max.min = _mm512_reduce_min_epi32(_mm512_min_epi32(vmin0, vmin1));
+    min_max.max = _mm512_reduce_max_epi32(_mm512_max_epi32(vmax0, vmax1));
+    return min_max;
+}
+
+static bool SupportsSSE41(void) { return __builtin_cpu_supports("sse4.1"); }
+static bool SupportsAVX2(void) { return __builtin_cpu_supports("avx2"); }
+static bool SupportsAVX512(void) { return __builtin_cpu_supports("avx512f"); }
+
+#endif
+
+static bool SupportsAlways(void) { return true; }
+
+// Таблица реализаций: от самой быстрой к эталонной
+static const struct {
+    const char *name;
+    MinMaxFn fn;
+    bool (*supported)(void);
+} kKernels[] = {
+#ifdef MIN_MAX_X86
+    {"avx512", GetMinMaxAVX512, SupportsAVX512},
+    {"avx2", GetMinMaxAVX2, SupportsAVX2},
+    {"sse4.1", GetMinMaxSSE41, SupportsSSE41},
+#endif
+    {"scalar", GetMinMaxScalar, SupportsAlways},
+};
+
+static const size_t kKernelsCount = sizeof(kKernels) / sizeof(kKernels[0]);
+static size_t current_kernel = sizeof(kKernels) / sizeof(kKernels[0]) - 1;
+
+bool SetMinMaxKernel(const char *name) {
+    bool is_auto = strcmp(name, "auto") == 0;
+    for (size_t i = 0; i < kKernelsCount; i++) {
+        if ((is_auto || strcmp(name, kKernels[i].name) == 0) && kKernels[i].supported()) {
+            current_kernel = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *GetMinMaxKernelName(void) {
+    return kKernels[current_kernel].name;
+}
+
+// Выбор лучшей реализации при запуске программы. Конструктор может
+// выполниться раньше инициализации libgcc, поэтому данные cpuid для
+// __builtin_cpu_supports заполняются явно
+__attribute__((constructor))
+static void InitMinMaxKernel(void) {
+#ifdef MIN_MAX_X86
+    __builtin_cpu_init();
+#endif
+    SetMinMaxKernel("auto");
+}
+
+void MergeMinMax(struct MinMax *acc, struct MinMax part) {
+    if (part.min < acc->min) acc->min = part.min;
+    if (part.max > acc->max) acc->max = part.max;
+}
+
+struct MinMax GetMinMax(int *array, unsigned int begin, unsigned int end) {
+    if (begin >= end) {
+        return GetMinMaxScalar(array, begin, end);
+    }
+    return kKernels[current_kernel].fn(array, begin, end);
+}
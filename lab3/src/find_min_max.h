@@ -1,8 +1,22 @@
 #ifndef FIND_MIN_MAX_H
 #define FIND_MIN_MAX_H
 
+#include <stdbool.h>
+
 #include "utils.h"
 
+// Поиск min/max в [begin, end) текущей реализацией (SIMD при наличии)
 struct MinMax GetMinMax(int *array, unsigned int begin, unsigned int end);
 
+// Эталонная скалярная реализация, доступна всегда
+struct MinMax GetMinMaxScalar(int *array, unsigned int begin, unsigned int end);
+
+// Выбор реализации: "auto", "avx512", "avx2", "sse4.1" или "scalar".
+// Возвращает false, если имя неизвестно или процессор ее не поддерживает.
+bool SetMinMaxKernel(const char *name);
+const char *GetMinMaxKernelName(void);
+
+// Объединение частичного результата с накопленным
+void MergeMinMax(struct MinMax *acc, struct MinMax part);
+
 #endif
@@ -5,30 +5,116 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <getopt.h>
+#include "affinity.h"
 #include "find_min_max.h"
+#include "stream_min_max.h"
+#include "thread_pool.h"
 #include "utils.h"
 
+// Способ распараллеливания и передачи результатов
+enum Mode {
+  MODE_PIPE,    // Процессы, результаты через общий pipe
+  MODE_FILES,   // Процессы, результаты через временные файлы
+  MODE_THREADS, // Постоянный пул потоков, результаты в выровненных слотах
+  MODE_SHM      // Процессы, массив и результаты в общей памяти (mmap MAP_SHARED)
+};
+
+// Аргументы задачи для пула потоков
+struct ThreadsArgs {
+  int *array;
+  int array_size;
+  int segment_size;
+  int pnum;
+  struct PaddedMinMax *results;  // По одному слоту на поток
+  unsigned int seed;
+  struct WorkerStats *stats;     // Замеры потоков для отчета по NUMA-узлам
+};
+
+// Границы сегмента i: последний сегмент забирает остаток массива
+static int SegmentEnd(int i, int pnum, int segment_size, int array_size) {
+  return (i == pnum - 1) ? array_size : (i + 1) * segment_size;
+}
+
+static double NowMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void ThreadsMinMax(void *args, unsigned int worker) {
+  struct ThreadsArgs *targs = (struct ThreadsArgs *)args;
+  int i = (int)worker;
+  int begin = i * targs->segment_size;
+  int end = SegmentEnd(i, targs->pnum, targs->segment_size, targs->array_size);
+
+  double start_ms = NowMs();
+  targs->results[i].value = GetMinMax(targs->array, begin, end);
+  targs->stats[i].elapsed_ms = NowMs() - start_ms;
+  targs->stats[i].bytes = (uint64_t)(end - begin) * sizeof(int);
+  targs->stats[i].node = CurrentNumaNode();
+}
+
+static void PinWorker(void *args, unsigned int worker) {
+  (void)args;
+  PinToCpu(worker);
+}
+
+// Первое касание: поток заполняет свой сегмент, и страницы попадают на его узел
+static void FirstTouch(void *args, unsigned int worker) {
+  struct ThreadsArgs *targs = (struct ThreadsArgs *)args;
+  int i = (int)worker;
+  GenerateArrayRange(targs->array, i * targs->segment_size,
+                     SegmentEnd(i, targs->pnum, targs->segment_size, targs->array_size),
+                     targs->seed);
+}
+
+static bool ParseMode(const char *name, enum Mode *mode) {
+  if (strcmp(name, "pipe") == 0) {
+    *mode = MODE_PIPE;
+  } else if (strcmp(name, "files") == 0) {
+    *mode = MODE_FILES;
+  } else if (strcmp(name, "threads") == 0) {
+    *mode = MODE_THREADS;
+  } else if (strcmp(name, "shm") == 0) {
+    *mode = MODE_SHM;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 int main(int argc, char **argv) {
   // Инициализация параметров
   int seed = -1;         // Seed для генератора случайных чисел
   int array_size = -1;   // Размер массива
-  int pnum = -1;         // Количество процессов
-  bool with_files = false; // Флаг использования файлов для синхронизации
+  int pnum = -1;         // Количество процессов или потоков
+  enum Mode mode = MODE_PIPE; // Способ синхронизации
+  const char *input = NULL;   // Файл с данными вместо генерации массива
+  enum InputFormat format = INPUT_BINARY;
+  bool numa = false;          // Потоки сами размещают свои сегменты на своих узлах
+  bool pin = false;           // Потоки/процессы привязываются к процессорам
 
   // Обработка аргументов командной строки
   while (true) {
-    int current_optind = optind ? optind : 1;
-
     // Определение возможных опций
     static struct option options[] = {
       {"seed", required_argument, 0, 0},       // --seed число
       {"array_size", required_argument, 0, 0}, // --array_size число
       {"pnum", required_argument, 0, 0},       // --pnum число
-      {"by_files", no_argument, 0, 'f'},       // --by_files
+      {"by_files", no_argument, 0, 'f'},       // --by_files (то же, что --mode=files)
+      {"kernel", required_argument, 0, 0},     // --kernel auto|avx512|avx2|sse4.1|scalar
+      {"mode", required_argument, 0, 0},       // --mode pipe|files|threads|shm
+      {"by_shm", no_argument, 0, 0},           // --by_shm (то же, что --mode=shm)
+      {"input", required_argument, 0, 0},      // --input файл или "-" для stdin
+      {"format", required_argument, 0, 0},     // --format bin|text
+      {"numa", no_argument, 0, 0},             // --numa (только --mode threads)
+      {"pin", no_argument, 0, 0},              // --pin
       {0, 0, 0, 0}
     };
 
@@ -56,20 +142,50 @@ int main(int argc, char **argv) {
             break;
           case 2: // --pnum
             pnum = atoi(optarg);
-            if (pnum <= 0 || pnum > array_size) {
-              printf("Pnum should be a positive number less than or equal to array size\n");
+            if (pnum <= 0) {
+              printf("Pnum should be a positive number\n");
               return 1;
             }
             break;
           case 3: // --by_files
-            with_files = true;
+            mode = MODE_FILES;
+            break;
+          case 4: // --kernel
+            if (!SetMinMaxKernel(optarg)) {
+              printf("Kernel %s is unknown or not supported by this CPU\n", optarg);
+              return 1;
+            }
+            break;
+          case 5: // --mode
+            if (!ParseMode(optarg, &mode)) {
+              printf("Mode should be one of: pipe, files, threads, shm\n");
+              return 1;
+            }
+            break;
+          case 6: // --by_shm
+            mode = MODE_SHM;
+            break;
+          case 7: // --input
+            input = optarg;
+            break;
+          case 8: // --format
+            if (!ParseInputFormat(optarg, &format)) {
+              printf("Format should be one of: bin, text\n");
+              return 1;
+            }
+            break;
+          case 9: // --numa
+            numa = true;
+            break;
+          case 10: // --pin
+            pin = true;
             break;
           default:
             printf("Index %d is out of options\n", option_index);
         }
         break;
       case 'f': // Краткая форма --by_files
-        with_files = true;
+        mode = MODE_FILES;
         break;
       case '?': // Нераспознанная опция
         break;
@@ -78,44 +194,156 @@ int main(int argc, char **argv) {
     }
   }
 
+  // Обработка файла или stdin: бинарный файл отображается в память
+  // и делится между pnum потоками, остальное читается блоками
+  if (input != NULL) {
+    struct timeval start_time;
+    gettimeofday(&start_time, NULL);
+
+    struct MinMax min_max;
+    uint64_t count;
+    if (MinMaxFromInput(input, format, pnum > 0 ? pnum : 1, &min_max, &count) != 0) {
+      return 1;
+    }
+
+    struct timeval finish_time;
+    gettimeofday(&finish_time, NULL);
+    double elapsed_time = (finish_time.tv_sec - start_time.tv_sec) * 1000.0;
+    elapsed_time += (finish_time.tv_usec - start_time.tv_usec) / 1000.0;
+
+    printf("Min: %d\n", min_max.min);
+    printf("Max: %d\n", min_max.max);
+    printf("Count: %llu\n", (unsigned long long)count);
+    printf("Elapsed time: %fms\n", elapsed_time);
+    printf("Kernel: %s\n", GetMinMaxKernelName());
+    return 0;
+  }
+
   // Проверка обязательных аргументов
   if (seed == -1 || array_size == -1 || pnum == -1) {
-    printf("Usage: %s --seed \"num\" --array_size \"num\" --pnum \"num\" \n", argv[0]);
+    printf("Usage: %s --seed \"num\" --array_size \"num\" --pnum \"num\" "
+           "[--mode pipe|files|threads|shm] [--kernel \"name\"] [--numa] [--pin]\n"
+           "       %s --input file|- [--format bin|text] [--pnum \"num\"] [--kernel \"name\"]\n",
+           argv[0], argv[0]);
+    return 1;
+  }
+  if (pnum > array_size) {
+    printf("Pnum should be a positive number less than or equal to array size\n");
+    return 1;
+  }
+  // Размещать сегменты могут только потоки общего пула; без привязки
+  // первое касание не гарантирует нужный узел
+  if (numa && mode != MODE_THREADS) {
+    printf("Warning: --numa is supported only with --mode threads\n");
+    numa = false;
+  }
+  if (numa) {
+    pin = true;
+  }
+  AffinityInit();
+
+  // Создание и заполнение массива. В режиме shm массив и слоты результатов
+  // лежат в одной общей анонимной области, отображенной до fork: дочерние
+  // процессы видят те же страницы без копирования при записи
+  int *array = NULL;
+  struct PaddedMinMax *shm_results = NULL;
+  size_t shm_size = 0;
+  if (mode == MODE_SHM) {
+    size_t slots_size = sizeof(struct PaddedMinMax) * pnum;
+    shm_size = slots_size + sizeof(int) * array_size;
+    void *shm = mmap(NULL, shm_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shm == MAP_FAILED) {
+      perror("mmap");
+      return 1;
+    }
+    shm_results = (struct PaddedMinMax *)shm;
+    array = (int *)((char *)shm + slots_size);
+    // Нули из mmap выглядели бы как найденные min = max = 0: слот
+    // упавшего процесса должен быть нейтральным для свертки
+    for (int i = 0; i < pnum; i++) {
+      shm_results[i].value.min = INT_MAX;
+      shm_results[i].value.max = INT_MIN;
+    }
+  } else {
+    array = malloc(sizeof(int) * array_size);
+  }
+  if (array == NULL) {
+    printf("Error: unable to allocate memory for array\n");
     return 1;
   }
+  if (!numa) {
+    GenerateArray(array, array_size, seed);
+  }
+
+  // Пул потоков создается до начала замера, но время его создания и
+  // привязки потоков прибавляется к замеру: процессные режимы платят за
+  // fork и привязку внутри замера. Первое касание - это генерация
+  // массива, которая не замеряется ни в одном режиме
+  double setup_time = 0;
+  struct ThreadPool *pool = NULL;
+  struct PaddedMinMax *results = NULL;
+  struct WorkerStats *stats = NULL;
+  int segment_size = array_size / pnum;
+  struct ThreadsArgs targs = {array, array_size, segment_size, pnum, NULL, seed, NULL};
+  if (mode == MODE_THREADS) {
+    double setup_start = NowMs();
+    pool = ThreadPoolCreate(pnum);
+    results = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct PaddedMinMax) * pnum);
+    stats = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct WorkerStats) * pnum);
+    if (pool == NULL || results == NULL || stats == NULL) {
+      printf("Error: unable to create thread pool\n");
+      return 1;
+    }
+    targs.results = results;
+    targs.stats = stats;
+
+    if (pin) {
+      ThreadPoolRun(pool, PinWorker, NULL);
+    }
+    setup_time = NowMs() - setup_start;
+    if (numa) {
+      ThreadPoolRun(pool, FirstTouch, &targs);
+    }
+  }
 
-  // Создание и заполнение массива
-  int *array = malloc(sizeof(int) * array_size);
-  GenerateArray(array, array_size, seed);
-  
   int active_child_processes = 0;
   struct timeval start_time;
   gettimeofday(&start_time, NULL); // Замер времени начала
 
+  // Буфер stdout сбрасывается, чтобы дочерние процессы не вывели его повторно
+  fflush(NULL);
+
   // Создание pipe (если используется pipe-синхронизация)
   int pipefd[2];
-  if (!with_files) {
+  if (mode == MODE_PIPE) {
     if (pipe(pipefd) == -1) {
       perror("pipe");
       return 1;
     }
   }
 
-  // Разделение работы между процессами
-  int segment_size = array_size / pnum;
+  // Разделение работы между процессами или потоками
+  if (mode == MODE_THREADS) {
+    ThreadPoolRun(pool, ThreadsMinMax, &targs);
+  }
 
-  for (int i = 0; i < pnum; i++) {
+  for (int i = 0; mode != MODE_THREADS && i < pnum; i++) {
     pid_t child_pid = fork(); // Создание дочернего процесса
-    
+
     if (child_pid >= 0) {
       active_child_processes += 1;
-      
+
       if (child_pid == 0) { // Код, выполняемый в дочернем процессе
+        if (pin) {
+          PinToCpu(i);
+        }
         // Поиск min/max в своем сегменте массива
-        struct MinMax min_max = GetMinMax(array, i * segment_size, (i + 1) * segment_size);
+        struct MinMax min_max = GetMinMax(array, i * segment_size,
+                                          SegmentEnd(i, pnum, segment_size, array_size));
 
-        if (with_files) { // Вариант с файлами
-          char filename[16];
+        if (mode == MODE_FILES) { // Вариант с файлами
+          char filename[32];
           snprintf(filename, sizeof(filename), "temp%d.txt", i);
           FILE *file = fopen(filename, "w");
           if (file == NULL) {
@@ -124,6 +352,8 @@ int main(int argc, char **argv) {
           }
           fprintf(file, "%d %d\n", min_max.min, min_max.max);
           fclose(file);
+        } else if (mode == MODE_SHM) { // Вариант с общей памятью
+          shm_results[i].value = min_max;
         } else { // Вариант с pipe
           write(pipefd[1], &min_max, sizeof(struct MinMax));
         }
@@ -136,7 +366,7 @@ int main(int argc, char **argv) {
   }
 
   // Закрытие записи в pipe (в родительском процессе)
-  if (!with_files) {
+  if (mode == MODE_PIPE) {
     close(pipefd[1]);
   }
 
@@ -155,8 +385,8 @@ int main(int argc, char **argv) {
     int min = INT_MAX;
     int max = INT_MIN;
 
-    if (with_files) { // Чтение из файлов
-      char filename[16];
+    if (mode == MODE_FILES) { // Чтение из файлов
+      char filename[32];
       snprintf(filename, sizeof(filename), "temp%d.txt", i);
       FILE *file = fopen(filename, "r");
       if (file == NULL) {
@@ -166,20 +396,24 @@ int main(int argc, char **argv) {
       fscanf(file, "%d %d", &min, &max);
       fclose(file);
       remove(filename); // Удаление временного файла
-    } else { // Чтение из pipe
+    } else if (mode == MODE_PIPE) { // Чтение из pipe
       struct MinMax temp;
       read(pipefd[0], &temp, sizeof(struct MinMax));
       min = temp.min;
       max = temp.max;
+    } else { // Чтение из слотов потоков или общей памяти
+      struct PaddedMinMax *slots = (mode == MODE_SHM) ? shm_results : results;
+      min = slots[i].value.min;
+      max = slots[i].value.max;
     }
-    
+
     // Обновление глобальных min/max
     if (min < min_max.min) min_max.min = min;
     if (max > min_max.max) min_max.max = max;
   }
 
   // Закрытие чтения из pipe
-  if (!with_files) {
+  if (mode == MODE_PIPE) {
     close(pipefd[0]);
   }
 
@@ -189,14 +423,31 @@ int main(int argc, char **argv) {
 
   double elapsed_time = (finish_time.tv_sec - start_time.tv_sec) * 1000.0;
   elapsed_time += (finish_time.tv_usec - start_time.tv_usec) / 1000.0;
+  elapsed_time += setup_time;
 
   // Освобождение ресурсов
-  free(array);
+  if (pool != NULL) {
+    ThreadPoolDestroy(pool);
+  }
+  free(results);
+  if (mode == MODE_SHM) {
+    munmap(shm_results, shm_size);
+  } else {
+    free(array);
+  }
 
   // Вывод результатов
   printf("Min: %d\n", min_max.min);
   printf("Max: %d\n", min_max.max);
   printf("Elapsed time: %fms\n", elapsed_time);
+  if (mode == MODE_THREADS) {
+    printf("Setup time: %fms\n", setup_time);
+  }
+  printf("Kernel: %s\n", GetMinMaxKernelName());
+  if (mode == MODE_THREADS && pin) {
+    PrintNodeThroughput(stats, pnum);
+  }
+  free(stats);
   fflush(NULL);
   return 0;
-}
\ No newline at end of file
+}
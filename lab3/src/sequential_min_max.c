@@ -1,21 +1,74 @@
 #include <stdio.h>   // Для ввода-вывода (printf)
 #include <stdlib.h>  // Для работы с памятью (malloc, free) и конвертации (atoi)
+#include <stdint.h>  // Для uint64_t
+#include <getopt.h>  // Для разбора опций --kernel, --input, --format
 
 // Подключение пользовательских заголовочных файлов
 #include "find_min_max.h"  // Содержит объявление структуры MinMax и функции GetMinMax
+#include "stream_min_max.h" // Потоковая обработка файлов и stdin
 #include "utils.h"         // Содержит объявление функции GenerateArray
 
 // Главная функция программы
 int main(int argc, char **argv) {
+  // Необязательные опции: --kernel выбирает реализацию GetMinMax,
+  // --input читает данные из файла или stdin ("-") вместо генерации
+  static struct option options[] = {
+    {"kernel", required_argument, 0, 'k'},
+    {"input", required_argument, 0, 'i'},
+    {"format", required_argument, 0, 'F'},
+    {0, 0, 0, 0}
+  };
+
+  const char *input = NULL;
+  enum InputFormat format = INPUT_BINARY;
+  int c;
+  while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (c) {
+      case 'k':
+        if (!SetMinMaxKernel(optarg)) {
+          printf("Kernel %s is unknown or not supported by this CPU\n", optarg);
+          return 1;
+        }
+        break;
+      case 'i':
+        input = optarg;
+        break;
+      case 'F':
+        if (!ParseInputFormat(optarg, &format)) {
+          printf("Format should be one of: bin, text\n");
+          return 1;
+        }
+        break;
+      default:
+        return 1;
+    }
+  }
+
+  // Данные из файла обрабатываются блоками, не загружаясь в память целиком
+  if (input != NULL) {
+    struct MinMax min_max;
+    uint64_t count;
+    if (MinMaxFromInput(input, format, 1, &min_max, &count) != 0) {
+      return 1;
+    }
+    printf("min: %d\n", min_max.min);
+    printf("max: %d\n", min_max.max);
+    printf("count: %llu\n", (unsigned long long)count);
+    printf("kernel: %s\n", GetMinMaxKernelName());
+    return 0;
+  }
+
   // Проверка количества аргументов командной строки
-  // Ожидается 2 аргумента (seed и array_size) + имя программы (argv[0])
-  if (argc != 3) {
-    printf("Usage: %s seed arraysize\n", argv[0]);  // Вывод правильного формата вызова
+  // Ожидается 2 позиционных аргумента (seed и array_size)
+  if (argc - optind != 2) {
+    printf("Usage: %s [--kernel auto|avx512|avx2|sse4.1|scalar] seed arraysize\n"
+           "       %s [--kernel name] --input file|- [--format bin|text]\n",
+           argv[0], argv[0]);  // Вывод правильного формата вызова
     return 1;  // Возврат кода ошибки
   }
 
   // Преобразование первого аргумента (seed) в число
-  int seed = atoi(argv[1]);
+  int seed = atoi(argv[optind]);
   // Проверка что seed - положительное число
   if (seed <= 0) {
     printf("seed is a positive number\n");
@@ -23,7 +76,7 @@ int main(int argc, char **argv) {
   }
 
   // Преобразование второго аргумента (array_size) в число
-  int array_size = atoi(argv[2]);
+  int array_size = atoi(argv[optind + 1]);
   // Проверка что array_size - положительное число
   if (array_size <= 0) {
     printf("array_size is a positive number\n");
@@ -48,6 +101,7 @@ int main(int argc, char **argv) {
   // Вывод результатов
   printf("min: %d\n", min_max.min);
   printf("max: %d\n", min_max.max);
+  printf("kernel: %s\n", GetMinMaxKernelName());
 
   // Успешное завершение программы
   return 0;
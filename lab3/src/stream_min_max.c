@@ -0,0 +1,250 @@
+#include "stream_min_max.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "find_min_max.h"
+#include "thread_pool.h"
+
+// Размер блока: столько данных держится в памяти одним потоком одновременно
+#define STREAM_CHUNK_BYTES (8u << 20)
+
+// Аргументы обработки отображенного файла
+struct MappedArgs {
+  const char *data;
+  size_t size;          // Размер данных, кратный sizeof(int)
+  size_t range_size;    // Размер части одного потока, кратный странице
+  struct PaddedMinMax *results;
+};
+
+static void MappedMinMax(void *args, unsigned int worker) {
+  struct MappedArgs *margs = (struct MappedArgs *)args;
+  struct MinMax min_max = {INT_MAX, INT_MIN};
+
+  size_t begin = margs->range_size * worker;
+  size_t end = begin + margs->range_size;
+  if (begin > margs->size) begin = margs->size;
+  if (end > margs->size) end = margs->size;
+
+  for (size_t offset = begin; offset < end; offset += STREAM_CHUNK_BYTES) {
+    size_t chunk = end - offset < STREAM_CHUNK_BYTES ? end - offset : STREAM_CHUNK_BYTES;
+    char *ptr = (char *)margs->data + offset;
+
+    // Просим ядро заранее подчитать следующий блок, пока считаем текущий
+    if (offset + chunk < end) {
+      size_t next = end - offset - chunk;
+      madvise(ptr + chunk, next < STREAM_CHUNK_BYTES ? next : STREAM_CHUNK_BYTES,
+              MADV_WILLNEED);
+    }
+
+    MergeMinMax(&min_max, GetMinMax((int *)ptr, 0, chunk / sizeof(int)));
+
+    // Обработанные страницы больше не нужны: память процесса ограничена блоком
+    madvise(ptr, chunk, MADV_DONTNEED);
+  }
+
+  margs->results[worker].value = min_max;
+}
+
+static int MinMaxFromMappedFile(int fd, size_t file_size, unsigned int threads,
+                                struct MinMax *min_max, uint64_t *count) {
+  size_t size = file_size - file_size % sizeof(int);
+  if (size != file_size) {
+    fprintf(stderr, "Warning: ignoring %zu trailing bytes\n", file_size - size);
+  }
+  *count = size / sizeof(int);
+  if (size == 0) {
+    return 0;
+  }
+
+  char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    perror("mmap");
+    return -1;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+  posix_fadvise(fd, 0, size, POSIX_FADV_SEQUENTIAL);
+
+  // Части потоков выровнены на страницу: потоки не делят страницы
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t range_size = (size + threads - 1) / threads;
+  range_size = (range_size + page - 1) / page * page;
+
+  struct PaddedMinMax *results =
+      aligned_alloc(CACHE_LINE_SIZE, sizeof(struct PaddedMinMax) * threads);
+  struct ThreadPool *pool = ThreadPoolCreate(threads);
+  if (results == NULL || pool == NULL) {
+    fprintf(stderr, "Error: unable to create thread pool\n");
+    free(results);
+    munmap(data, size);
+    return -1;
+  }
+
+  struct MappedArgs margs = {data, size, range_size, results};
+  ThreadPoolRun(pool, MappedMinMax, &margs);
+
+  for (unsigned int i = 0; i < threads; i++) {
+    MergeMinMax(min_max, results[i].value);
+  }
+
+  ThreadPoolDestroy(pool);
+  free(results);
+  munmap(data, size);
+  return 0;
+}
+
+// Бинарный поток: число может оказаться разрезанным между двумя чтениями
+static int MinMaxFromBinaryStream(int fd, char *buf, struct MinMax *min_max,
+                                  uint64_t *count) {
+  size_t filled = 0;
+  while (true) {
+    ssize_t nread = read(fd, buf + filled, STREAM_CHUNK_BYTES - filled);
+    if (nread < 0) {
+      if (errno == EINTR) continue;
+      perror("read");
+      return -1;
+    }
+    if (nread == 0) break;
+    filled += nread;
+
+    size_t values = filled / sizeof(int);
+    MergeMinMax(min_max, GetMinMax((int *)buf, 0, values));
+    *count += values;
+
+    // Недочитанный хвост переносится в начало буфера
+    size_t rest = filled - values * sizeof(int);
+    memmove(buf, buf + values * sizeof(int), rest);
+    filled = rest;
+  }
+  if (filled != 0) {
+    fprintf(stderr, "Warning: ignoring %zu trailing bytes\n", filled);
+  }
+  return 0;
+}
+
+// Текстовый поток: числа разбираются в промежуточный массив int
+static int MinMaxFromTextStream(int fd, char *buf, struct MinMax *min_max,
+                                uint64_t *count) {
+  int *values = malloc(STREAM_CHUNK_BYTES / 2 * sizeof(int));
+  if (values == NULL) {
+    fprintf(stderr, "Error: unable to allocate memory for values\n");
+    return -1;
+  }
+
+  size_t filled = 0;
+  bool eof = false;
+  int status = 0;
+  while (!eof) {
+    ssize_t nread = read(fd, buf + filled, STREAM_CHUNK_BYTES - filled);
+    if (nread < 0) {
+      if (errno == EINTR) continue;
+      perror("read");
+      status = -1;
+      break;
+    }
+    eof = nread == 0;
+    filled += nread;
+
+    // Последнее число в буфере может продолжиться в следующем блоке
+    size_t limit = filled;
+    if (!eof) {
+      while (limit > 0 && (buf[limit - 1] == '-' ||
+                           (buf[limit - 1] >= '0' && buf[limit - 1] <= '9'))) {
+        limit--;
+      }
+      if (limit == 0 && filled == STREAM_CHUNK_BYTES) {
+        fprintf(stderr, "Error: token longer than %u bytes\n", STREAM_CHUNK_BYTES);
+        status = -1;
+        break;
+      }
+    }
+
+    size_t values_num = 0;
+    for (size_t i = 0; i < limit;) {
+      bool negative = buf[i] == '-';
+      size_t digits = i + (negative ? 1 : 0);
+      if (digits >= limit || buf[digits] < '0' || buf[digits] > '9') {
+        i++;
+        continue;
+      }
+      long long value = 0;
+      for (i = digits; i < limit && buf[i] >= '0' && buf[i] <= '9'; i++) {
+        value = value * 10 + (buf[i] - '0');
+        if (value > (long long)INT_MAX + 1) break;
+      }
+      if (negative) value = -value;
+      if (value < INT_MIN || value > INT_MAX) {
+        fprintf(stderr, "Error: value out of int range\n");
+        free(values);
+        return -1;
+      }
+      values[values_num++] = (int)value;
+    }
+
+    MergeMinMax(min_max, GetMinMax(values, 0, values_num));
+    *count += values_num;
+
+    memmove(buf, buf + limit, filled - limit);
+    filled -= limit;
+  }
+
+  free(values);
+  return status;
+}
+
+bool ParseInputFormat(const char *name, enum InputFormat *format) {
+  if (strcmp(name, "bin") == 0) {
+    *format = INPUT_BINARY;
+  } else if (strcmp(name, "text") == 0) {
+    *format = INPUT_TEXT;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int MinMaxFromInput(const char *path, enum InputFormat format, unsigned int threads,
+                    struct MinMax *min_max, uint64_t *count) {
+  min_max->min = INT_MAX;
+  min_max->max = INT_MIN;
+  *count = 0;
+
+  bool is_stdin = strcmp(path, "-") == 0;
+  int fd = is_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+  if (fd < 0) {
+    perror("File opening failed");
+    return -1;
+  }
+
+  int status;
+  struct stat st;
+  if (format == INPUT_BINARY && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    status = MinMaxFromMappedFile(fd, (size_t)st.st_size, threads > 0 ? threads : 1,
+                                  min_max, count);
+  } else {
+    char *buf = malloc(STREAM_CHUNK_BYTES);
+    if (buf == NULL) {
+      fprintf(stderr, "Error: unable to allocate memory for buffer\n");
+      status = -1;
+    } else {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      status = (format == INPUT_BINARY)
+                   ? MinMaxFromBinaryStream(fd, buf, min_max, count)
+                   : MinMaxFromTextStream(fd, buf, min_max, count);
+      free(buf);
+    }
+  }
+
+  if (!is_stdin) {
+    close(fd);
+  }
+  return status;
+}
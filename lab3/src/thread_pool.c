@@ -0,0 +1,120 @@
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+struct ThreadPool {
+    pthread_t *threads;
+    unsigned int threads_num;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;   // Появилась новая задача
+    pthread_cond_t done_cond;   // Все потоки закончили задачу
+
+    ThreadPoolTask task;
+    void *arg;
+    unsigned long generation;   // Номер текущей задачи
+    unsigned int pending;       // Сколько потоков еще работают
+    bool stop;
+};
+
+struct WorkerArgs {
+    struct ThreadPool *pool;
+    unsigned int index;
+};
+
+static void *Worker(void *args) {
+    struct WorkerArgs *worker = (struct WorkerArgs *)args;
+    struct ThreadPool *pool = worker->pool;
+    unsigned int index = worker->index;
+    free(worker);
+
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->mutex);
+    while (true) {
+        // Ждем новую задачу или сигнал остановки
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        }
+        if (pool->stop) break;
+
+        seen = pool->generation;
+        ThreadPoolTask task = pool->task;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->mutex);
+
+        task(arg, index);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+struct ThreadPool *ThreadPoolCreate(unsigned int threads) {
+    struct ThreadPool *pool = calloc(1, sizeof(struct ThreadPool));
+    if (pool == NULL) return NULL;
+
+    pool->threads = malloc(sizeof(pthread_t) * threads);
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    for (unsigned int i = 0; i < threads; i++) {
+        struct WorkerArgs *args = malloc(sizeof(struct WorkerArgs));
+        if (args != NULL) {
+            args->pool = pool;
+            args->index = i;
+        }
+        if (args == NULL || pthread_create(&pool->threads[i], NULL, Worker, args) != 0) {
+            free(args);
+            ThreadPoolDestroy(pool);
+            return NULL;
+        }
+        pool->threads_num++;
+    }
+    return pool;
+}
+
+void ThreadPoolRun(struct ThreadPool *pool, ThreadPoolTask task, void *arg) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = pool->threads_num;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+unsigned int ThreadPoolSize(const struct ThreadPool *pool) {
+    return pool->threads_num;
+}
+
+void ThreadPoolDestroy(struct ThreadPool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (unsigned int i = 0; i < pool->threads_num; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    free(pool->threads);
+    free(pool);
+}
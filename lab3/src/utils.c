@@ -1,10 +1,98 @@
 #include "utils.h"
 
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-void GenerateArray(int *array, unsigned int array_size, unsigned int seed) {
-  srand(seed);
-  for (int i = 0; i < array_size; i++) {
-    array[i] = rand();
+#include <unistd.h>
+
+// Меньше этого числа элементов на поток создавать потоки невыгодно
+#define GENERATE_MIN_CHUNK (1u << 16)
+// Границы частей выравниваются на кэш-линию, чтобы потоки не делили линии
+#define GENERATE_ALIGN (CACHE_LINE_SIZE / sizeof(int))
+
+// Счетчиковый генератор SplitMix64: элемент i зависит только от seed и i,
+// поэтому любой диапазон можно заполнить независимо от остальных
+static inline uint64_t SplitMix64(uint64_t seed, uint64_t i) {
+  uint64_t z = seed + (i + 1) * 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+void GenerateArrayRange(int *array, unsigned int begin, unsigned int end,
+                        unsigned int seed) {
+  // Старшие 31 бит: значения в том же диапазоне [0, RAND_MAX], что и у rand()
+  for (unsigned int i = begin; i < end; i++) {
+    array[i] = (int)(SplitMix64(seed, i) >> 33);
+  }
+}
+
+struct GenerateArgs {
+  int *array;
+  unsigned int begin;
+  unsigned int end;
+  unsigned int seed;
+  bool started;  // Поток создан и его нужно дождаться
+};
+
+static void *ThreadGenerate(void *args) {
+  struct GenerateArgs *gargs = (struct GenerateArgs *)args;
+  GenerateArrayRange(gargs->array, gargs->begin, gargs->end, gargs->seed);
+  return NULL;
+}
+
+void GenerateArrayParallel(int *array, unsigned int array_size, unsigned int seed,
+                           unsigned int threads_num) {
+  if (threads_num == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads_num = cpus > 0 ? (unsigned int)cpus : 1;
+  }
+  if (threads_num > array_size / GENERATE_MIN_CHUNK) {
+    threads_num = array_size / GENERATE_MIN_CHUNK;
   }
+  if (threads_num <= 1) {
+    GenerateArrayRange(array, 0, array_size, seed);
+    return;
+  }
+
+  pthread_t *threads = malloc(sizeof(pthread_t) * threads_num);
+  struct GenerateArgs *args = malloc(sizeof(struct GenerateArgs) * threads_num);
+  if (threads == NULL || args == NULL) {
+    free(threads);
+    free(args);
+    GenerateArrayRange(array, 0, array_size, seed);
+    return;
+  }
+
+  // Первую часть заполняет сам вызывающий поток
+  for (unsigned int t = 0; t < threads_num; t++) {
+    uint64_t begin = (uint64_t)array_size * t / threads_num;
+    uint64_t end = (uint64_t)array_size * (t + 1) / threads_num;
+    args[t].array = array;
+    args[t].begin = (unsigned int)(begin - begin % GENERATE_ALIGN);
+    args[t].end = (t == threads_num - 1) ? array_size
+                                         : (unsigned int)(end - end % GENERATE_ALIGN);
+    args[t].seed = seed;
+    args[t].started = t > 0 &&
+                      pthread_create(&threads[t], NULL, ThreadGenerate, &args[t]) == 0;
+    if (t > 0 && !args[t].started) {
+      ThreadGenerate(&args[t]);  // Не удалось создать поток - заполняем сами
+    }
+  }
+  ThreadGenerate(&args[0]);
+
+  for (unsigned int t = 1; t < threads_num; t++) {
+    if (args[t].started) {
+      pthread_join(threads[t], NULL);
+    }
+  }
+
+  free(threads);
+  free(args);
+}
+
+void GenerateArray(int *array, unsigned int array_size, unsigned int seed) {
+  GenerateArrayParallel(array, array_size, seed, 0);
 }
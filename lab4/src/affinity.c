@@ -0,0 +1,67 @@
+#define _GNU_SOURCE
+#include "affinity.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int cpus[CPU_SETSIZE];
+static int cpus_count = 0;
+
+void AffinityInit(void) {
+  cpu_set_t set;
+  cpus_count = 0;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+    perror("sched_getaffinity");
+    return;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &set)) {
+      cpus[cpus_count++] = cpu;
+    }
+  }
+}
+
+int PinToCpu(unsigned int worker) {
+  if (cpus_count == 0) return -1;
+
+  int cpu = cpus[worker % cpus_count];
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (rc != 0) {
+    fprintf(stderr, "pthread_setaffinity_np failed for cpu %d\n", cpu);
+    return -1;
+  }
+  return cpu;
+}
+
+int CurrentNumaNode(void) {
+  unsigned int cpu, node;
+  if (getcpu(&cpu, &node) != 0) return 0;
+  return (int)node;
+}
+
+void PrintNodeThroughput(const struct WorkerStats *stats, unsigned int threads) {
+  int max_node = 0;
+  for (unsigned int i = 0; i < threads; i++) {
+    if (stats[i].node > max_node) max_node = stats[i].node;
+  }
+
+  for (int node = 0; node <= max_node; node++) {
+    unsigned int workers = 0;
+    uint64_t bytes = 0;
+    double slowest = 0;
+    for (unsigned int i = 0; i < threads; i++) {
+      if (stats[i].node != node) continue;
+      workers++;
+      bytes += stats[i].bytes;
+      if (stats[i].elapsed_ms > slowest) slowest = stats[i].elapsed_ms;
+    }
+    if (workers == 0) continue;
+    printf("Node %d: %u threads, %.3f GB/s\n", node, workers,
+           slowest > 0 ? bytes / (slowest * 1e6) : 0.0);
+  }
+}
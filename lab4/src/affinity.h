@@ -0,0 +1,30 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stdint.h>
+
+#include "utils.h"
+
+// Запоминает процессоры, доступные процессу. Вызывается из main до создания
+// потоков: привязанный поток видит уже только свой процессор.
+void AffinityInit(void);
+
+// Привязывает вызывающий поток к worker-му доступному процессору (по кругу).
+// Возвращает номер процессора или -1 при ошибке.
+int PinToCpu(unsigned int worker);
+
+// NUMA-узел процессора, на котором сейчас выполняется поток
+int CurrentNumaNode(void);
+
+// Замер одного потока для отчета о пропускной способности по узлам
+struct WorkerStats {
+  int node;
+  uint64_t bytes;
+  double elapsed_ms;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+// Печатает для каждого узла число потоков и GB/s (объем узла / время
+// самого медленного его потока)
+void PrintNodeThroughput(const struct WorkerStats *stats, unsigned int threads);
+
+#endif
@@ -0,0 +1,130 @@
+#!/bin/bash
+
+# Замер всех режимов параллельной редукции lab3/lab4
+# (parallel_min_max, parallel_sum и parallel_stats - какие есть в каталоге).
+# Каждая конфигурация запускается WARMUP раз вхолостую и REPEAT раз с замером;
+# по строкам "Elapsed time" считаются медиана, p95 и пропускная способность.
+#
+# Параметры задаются переменными окружения:
+#   SIZES   - размеры массива            (по умолчанию "1000000 10000000")
+#   PNUMS   - число процессов/потоков    (по умолчанию "1 2 4 8")
+#   MODES   - режимы parallel_min_max    (по умолчанию "pipe files threads shm")
+#   KERNELS - реализации GetMinMax       (по умолчанию "auto")
+#   SCHEDULES - планировщики parallel_sum (по умолчанию "static dynamic steal")
+#   SUM_KERNELS - реализации Sum         (по умолчанию "auto")
+#   REPEAT  - число замеров              (по умолчанию 10)
+#   WARMUP  - число прогревочных запусков (по умолчанию 2)
+#   FORMAT  - csv или json               (по умолчанию csv)
+#   SEED    - seed генератора            (по умолчанию 1)
+
+SIZES=${SIZES:-"1000000 10000000"}
+PNUMS=${PNUMS:-"1 2 4 8"}
+MODES=${MODES:-"pipe files threads shm"}
+KERNELS=${KERNELS:-"auto"}
+SCHEDULES=${SCHEDULES:-"static dynamic steal"}
+SUM_KERNELS=${SUM_KERNELS:-"auto"}
+REPEAT=${REPEAT:-10}
+WARMUP=${WARMUP:-2}
+FORMAT=${FORMAT:-csv}
+SEED=${SEED:-1}
+
+if [ "$FORMAT" != "csv" ] && [ "$FORMAT" != "json" ]; then
+    echo "FORMAT должен быть csv или json" >&2
+    exit 1
+fi
+
+first=1
+
+# Вывод одной строки результата: program mode kernel size pnum времена...
+report() {
+    local program=$1 mode=$2 kernel=$3 size=$4 pnum=$5
+    shift 5
+    printf "%s\n" "$@" | sort -g | awk -v program="$program" -v mode="$mode" \
+        -v kernel="$kernel" -v size="$size" -v pnum="$pnum" -v format="$FORMAT" \
+        -v first="$first" '
+        { t[NR] = $1 }
+        END {
+            if (NR == 0) exit 1
+            median = (NR % 2) ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2
+            # 95-й перцентиль по ближайшему рангу: ceil(0.95 * NR)
+            r = int(0.95 * NR)
+            if (r < 0.95 * NR) r++
+            p95 = t[r]
+            # Объем данных: size элементов int по 4 байта
+            gbps = (median > 0) ? size * 4 / (median * 1e6) : 0
+            if (format == "csv") {
+                printf "%s,%s,%s,%d,%d,%d,%.3f,%.3f,%.3f\n",
+                       program, mode, kernel, size, pnum, NR, median, p95, gbps
+            } else {
+                printf "%s  {\"program\": \"%s\", \"mode\": \"%s\", \"kernel\": \"%s\", " \
+                       "\"array_size\": %d, \"pnum\": %d, \"runs\": %d, " \
+                       "\"median_ms\": %.3f, \"p95_ms\": %.3f, \"gb_per_s\": %.3f}",
+                       first ? "" : ",\n", program, mode, kernel, size, pnum, NR,
+                       median, p95, gbps
+            }
+        }' && first=0
+}
+
+# Запуск конфигурации: прогрев, затем REPEAT замеров. Если программа
+# печатает строку "Kernel:", в отчет идет она: "auto" раскрывается в ядро,
+# которое программа выбрала на самом деле
+measure() {
+    local program=$1 mode=$2 kernel=$3 size=$4 pnum=$5
+    shift 5
+    local times=()
+    for ((run = 0; run < WARMUP + REPEAT; run++)); do
+        local output t reported
+        output=$("$@")
+        t=$(awk '/Elapsed time/ { sub(/ms$/, "", $3); print $3 }' <<< "$output")
+        reported=$(awk '/^Kernel:/ { print $2 }' <<< "$output")
+        if [ -n "$reported" ]; then
+            kernel=$reported
+        fi
+        if [ -z "$t" ]; then
+            echo "Ошибка запуска: $*" >&2
+            return
+        fi
+        if [ $run -ge $WARMUP ]; then
+            times+=("$t")
+        fi
+    done
+    report "$program" "$mode" "$kernel" "$size" "$pnum" "${times[@]}"
+}
+
+if [ "$FORMAT" = "csv" ]; then
+    echo "program,mode,kernel,array_size,pnum,runs,median_ms,p95_ms,gb_per_s"
+else
+    echo "["
+fi
+
+for size in $SIZES; do
+    for pnum in $PNUMS; do
+        if [ -x ./parallel_min_max ]; then
+            for mode in $MODES; do
+                for kernel in $KERNELS; do
+                    measure parallel_min_max "$mode" "$kernel" "$size" "$pnum" \
+                        ./parallel_min_max --seed "$SEED" --array_size "$size" \
+                        --pnum "$pnum" --mode "$mode" --kernel "$kernel"
+                done
+            done
+        fi
+        if [ -x ./parallel_sum ]; then
+            for schedule in $SCHEDULES; do
+                for kernel in $SUM_KERNELS; do
+                    measure parallel_sum "$schedule" "$kernel" "$size" "$pnum" \
+                        ./parallel_sum --seed "$SEED" --array_size "$size" \
+                        --threads_num "$pnum" --schedule "$schedule" --kernel "$kernel"
+                done
+            done
+        fi
+        if [ -x ./parallel_stats ]; then
+            measure parallel_stats fused all "$size" "$pnum" \
+                ./parallel_stats --seed "$SEED" --array_size "$size" --threads_num "$pnum"
+        fi
+    done
+done
+
+if [ "$FORMAT" = "json" ]; then
+    echo
+    echo "]"
+fi
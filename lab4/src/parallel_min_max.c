@@ -5,37 +5,124 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <getopt.h>
 #include <signal.h>  // Добавлено для работы с сигналами
 
+#include "affinity.h"
 #include "find_min_max.h"
+#include "stream_min_max.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 int timeout_flag = 0;
 
 void handle_alarm(int sig) {
+    (void)sig;
     timeout_flag = 1;  // Устанавливаем флаг таймаута
 }
 
+// Способ распараллеливания и передачи результатов
+enum Mode {
+    MODE_PIPE,    // Процессы, результаты через общий pipe
+    MODE_FILES,   // Процессы, результаты через временные файлы
+    MODE_THREADS, // Постоянный пул потоков, результаты в выровненных слотах
+    MODE_SHM      // Процессы, массив и результаты в общей памяти (mmap MAP_SHARED)
+};
+
+// Аргументы задачи для пула потоков
+struct ThreadsArgs {
+    int *array;
+    int array_size;
+    int segment_size;
+    int pnum;
+    struct PaddedMinMax *results;  // По одному слоту на поток
+    unsigned int seed;
+    struct WorkerStats *stats;     // Замеры потоков для отчета по NUMA-узлам
+};
+
+// Граница сегмента i: последний сегмент забирает остаток массива
+static int SegmentEnd(int i, int pnum, int segment_size, int array_size) {
+    return (i == pnum - 1) ? array_size : (i + 1) * segment_size;
+}
+
+static double NowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void ThreadsMinMax(void *args, unsigned int worker) {
+    struct ThreadsArgs *targs = (struct ThreadsArgs *)args;
+    int i = (int)worker;
+    int begin = i * targs->segment_size;
+    int end = SegmentEnd(i, targs->pnum, targs->segment_size, targs->array_size);
+
+    double start_ms = NowMs();
+    targs->results[i].value = GetMinMax(targs->array, begin, end);
+    targs->stats[i].elapsed_ms = NowMs() - start_ms;
+    targs->stats[i].bytes = (uint64_t)(end - begin) * sizeof(int);
+    targs->stats[i].node = CurrentNumaNode();
+}
+
+static void PinWorker(void *args, unsigned int worker) {
+    (void)args;
+    PinToCpu(worker);
+}
+
+// Первое касание: поток заполняет свой сегмент, и страницы попадают на его узел
+static void FirstTouch(void *args, unsigned int worker) {
+    struct ThreadsArgs *targs = (struct ThreadsArgs *)args;
+    int i = (int)worker;
+    GenerateArrayRange(targs->array, i * targs->segment_size,
+                       SegmentEnd(i, targs->pnum, targs->segment_size, targs->array_size),
+                       targs->seed);
+}
+
+static bool ParseMode(const char *name, enum Mode *mode) {
+    if (strcmp(name, "pipe") == 0) {
+        *mode = MODE_PIPE;
+    } else if (strcmp(name, "files") == 0) {
+        *mode = MODE_FILES;
+    } else if (strcmp(name, "threads") == 0) {
+        *mode = MODE_THREADS;
+    } else if (strcmp(name, "shm") == 0) {
+        *mode = MODE_SHM;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char **argv) {
     int seed = -1;
     int array_size = -1;
     int pnum = -1;
-    bool with_files = false;
+    enum Mode mode = MODE_PIPE;
     int timeout = -1; // Переменная для хранения таймаута
+    const char *input = NULL;
+    enum InputFormat format = INPUT_BINARY;
+    bool numa = false;  // Потоки сами размещают свои сегменты на своих узлах
+    bool pin = false;   // Потоки/процессы привязываются к процессорам
 
     while (true) {
-        int current_optind = optind ? optind : 1;
-
         static struct option options[] = {
             {"seed", required_argument, 0, 0},
             {"array_size", required_argument, 0, 0},
             {"pnum", required_argument, 0, 0},
             {"by_files", no_argument, 0, 'f'},
             {"timeout", required_argument, 0, 0}, // Опция для таймаута
+            {"kernel", required_argument, 0, 0},  // Реализация GetMinMax
+            {"mode", required_argument, 0, 0},    // pipe|files|threads|shm
+            {"by_shm", no_argument, 0, 0},        // То же, что --mode=shm
+            {"input", required_argument, 0, 0},   // Файл с данными или "-" для stdin
+            {"format", required_argument, 0, 0},  // bin|text
+            {"numa", no_argument, 0, 0},          // Только для --mode threads
+            {"pin", no_argument, 0, 0},           // Привязка к процессорам
             {0, 0, 0, 0}
         };
 
@@ -63,13 +150,13 @@ int main(int argc, char **argv) {
                         break;
                     case 2:
                         pnum = atoi(optarg);
-                        if (pnum <= 0 || pnum > array_size) {
-                            printf("Pnum should be a positive number less than or equal to array size\n");
+                        if (pnum <= 0) {
+                            printf("Pnum should be a positive number\n");
                             return 1;
                         }
                         break;
                     case 3:
-                        with_files = true;
+                        mode = MODE_FILES;
                         break;
                     case 4:
                         timeout = atoi(optarg);
@@ -78,12 +165,42 @@ int main(int argc, char **argv) {
                             return 1;
                         }
                         break;
+                    case 5:
+                        if (!SetMinMaxKernel(optarg)) {
+                            printf("Kernel %s is unknown or not supported by this CPU\n", optarg);
+                            return 1;
+                        }
+                        break;
+                    case 6:
+                        if (!ParseMode(optarg, &mode)) {
+                            printf("Mode should be one of: pipe, files, threads, shm\n");
+                            return 1;
+                        }
+                        break;
+                    case 7:
+                        mode = MODE_SHM;
+                        break;
+                    case 8:
+                        input = optarg;
+                        break;
+                    case 9:
+                        if (!ParseInputFormat(optarg, &format)) {
+                            printf("Format should be one of: bin, text\n");
+                            return 1;
+                        }
+                        break;
+                    case 10:
+                        numa = true;
+                        break;
+                    case 11:
+                        pin = true;
+                        break;
                     default:
                         printf("Index %d is out of options\n", option_index);
                 }
                 break;
             case 'f':
-                with_files = true;
+                mode = MODE_FILES;
                 break;
             case '?':
                 break;
@@ -92,27 +209,146 @@ int main(int argc, char **argv) {
         }
     }
 
+    // Данные из файла или stdin обрабатываются блоками с ограниченной памятью
+    if (input != NULL) {
+        struct timeval start_time;
+        gettimeofday(&start_time, NULL);
+
+        struct MinMax min_max;
+        uint64_t count;
+        if (MinMaxFromInput(input, format, pnum > 0 ? pnum : 1, &min_max, &count) != 0) {
+            return 1;
+        }
+
+        struct timeval finish_time;
+        gettimeofday(&finish_time, NULL);
+        double elapsed_time = (finish_time.tv_sec - start_time.tv_sec) * 1000.0;
+        elapsed_time += (finish_time.tv_usec - start_time.tv_usec) / 1000.0;
+
+        printf("Min: %d\n", min_max.min);
+        printf("Max: %d\n", min_max.max);
+        printf("Count: %llu\n", (unsigned long long)count);
+        printf("Elapsed time: %fms\n", elapsed_time);
+        printf("Kernel: %s\n", GetMinMaxKernelName());
+        return 0;
+    }
+
     if (seed == -1 || array_size == -1 || pnum == -1) {
-        printf("Usage: %s --seed \"num\" --array_size \"num\" --pnum \"num\" [--timeout \"num\"]\n", argv[0]);
+        printf("Usage: %s --seed \"num\" --array_size \"num\" --pnum \"num\" [--timeout \"num\"] "
+               "[--mode pipe|files|threads|shm] [--kernel \"name\"] [--numa] [--pin]\n"
+               "       %s --input file|- [--format bin|text] [--pnum \"num\"] [--kernel \"name\"]\n",
+               argv[0], argv[0]);
+        return 1;
+    }
+    if (pnum > array_size) {
+        printf("Pnum should be a positive number less than or equal to array size\n");
+        return 1;
+    }
+    // Потоки пула нельзя прервать посреди сегмента, как дочерние процессы
+    // по SIGKILL, поэтому таймаут в этом режиме не поддерживается
+    if (timeout > 0 && mode == MODE_THREADS) {
+        printf("--timeout is not supported with --mode threads\n");
+        return 1;
+    }
+    // Размещать сегменты могут только потоки общего пула; без привязки
+    // первое касание не гарантирует нужный узел
+    if (numa && mode != MODE_THREADS) {
+        printf("Warning: --numa is supported only with --mode threads\n");
+        numa = false;
+    }
+    if (numa) {
+        pin = true;
+    }
+    AffinityInit();
+
+    // В режиме shm массив и слоты результатов лежат в общей анонимной
+    // области, отображенной до fork, и не копируются при записи
+    int *array = NULL;
+    struct PaddedMinMax *shm_results = NULL;
+    size_t shm_size = 0;
+    if (mode == MODE_SHM) {
+        size_t slots_size = sizeof(struct PaddedMinMax) * pnum;
+        shm_size = slots_size + sizeof(int) * array_size;
+        void *shm = mmap(NULL, shm_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (shm == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+        shm_results = (struct PaddedMinMax *)shm;
+        array = (int *)((char *)shm + slots_size);
+        // Нули из mmap выглядели бы как найденные min = max = 0: слот
+        // убитого по таймауту процесса должен быть нейтральным для свертки
+        for (int i = 0; i < pnum; i++) {
+            shm_results[i].value.min = INT_MAX;
+            shm_results[i].value.max = INT_MIN;
+        }
+    } else {
+        array = malloc(sizeof(int) * array_size);
+    }
+    if (array == NULL) {
+        printf("Error: unable to allocate memory for array\n");
+        return 1;
+    }
+    if (!numa) {
+        GenerateArray(array, array_size, seed);
+    }
+
+    // Пул потоков создается до начала замера, но время его создания и
+    // привязки потоков прибавляется к замеру: процессные режимы платят за
+    // fork и привязку внутри замера. Первое касание - это генерация
+    // массива, которая не замеряется ни в одном режиме
+    double setup_time = 0;
+    struct ThreadPool *pool = NULL;
+    struct PaddedMinMax *results = NULL;
+    struct WorkerStats *stats = NULL;
+    int segment_size = array_size / pnum;
+    struct ThreadsArgs targs = {array, array_size, segment_size, pnum, NULL, seed, NULL};
+    if (mode == MODE_THREADS) {
+        double setup_start = NowMs();
+        pool = ThreadPoolCreate(pnum);
+        results = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct PaddedMinMax) * pnum);
+        stats = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct WorkerStats) * pnum);
+        if (pool == NULL || results == NULL || stats == NULL) {
+            printf("Error: unable to create thread pool\n");
+            return 1;
+        }
+        targs.results = results;
+        targs.stats = stats;
+
+        if (pin) {
+            ThreadPoolRun(pool, PinWorker, NULL);
+        }
+        setup_time = NowMs() - setup_start;
+        if (numa) {
+            ThreadPoolRun(pool, FirstTouch, &targs);
+        }
+    }
+
+    // PID дочерних процессов нужны, чтобы завершить их по таймауту
+    pid_t *child_pids = calloc(pnum, sizeof(pid_t));
+    // Слоты shm сливаются только от процессов, завершившихся штатно
+    bool *child_done = calloc(pnum, sizeof(bool));
+    if (child_pids == NULL || child_done == NULL) {
+        printf("Error: unable to allocate memory for child pids\n");
         return 1;
     }
 
-    int *array = malloc(sizeof(int) * array_size);
-    GenerateArray(array, array_size, seed);
     int active_child_processes = 0;
     struct timeval start_time;
     gettimeofday(&start_time, NULL);
 
+    // Буфер stdout сбрасывается, чтобы дочерние процессы не вывели его повторно
+    fflush(NULL);
+
     int pipefd[2];
-    if (!with_files) {
+    if (mode == MODE_PIPE) {
         if (pipe(pipefd) == -1) {
             perror("pipe");
             return 1;
         }
     }
 
-    int segment_size = array_size / pnum;
-
     // Установка обработчика сигнала
     signal(SIGALRM, handle_alarm);
 
@@ -120,15 +356,23 @@ int main(int argc, char **argv) {
         alarm(timeout); // Устанавливаем таймер
     }
 
-    for (int i = 0; i < pnum; i++) {
+    if (mode == MODE_THREADS) {
+        ThreadPoolRun(pool, ThreadsMinMax, &targs);
+    }
+
+    for (int i = 0; mode != MODE_THREADS && i < pnum; i++) {
         pid_t child_pid = fork();
         if (child_pid >= 0) {
             active_child_processes += 1;
             if (child_pid == 0) {
-                struct MinMax min_max = GetMinMax(array, i * segment_size, (i + 1) * segment_size);
+                if (pin) {
+                    PinToCpu(i);
+                }
+                struct MinMax min_max = GetMinMax(array, i * segment_size,
+                                                  SegmentEnd(i, pnum, segment_size, array_size));
 
-                if (with_files) {
-                    char filename[16];
+                if (mode == MODE_FILES) {
+                    char filename[32];
                     snprintf(filename, sizeof(filename), "temp%d.txt", i);
                     FILE *file = fopen(filename, "w");
                     if (file == NULL) {
@@ -137,33 +381,44 @@ int main(int argc, char **argv) {
                     }
                     fprintf(file, "%d %d\n", min_max.min, min_max.max);
                     fclose(file);
+                } else if (mode == MODE_SHM) {
+                    shm_results[i].value = min_max;
                 } else {
                     write(pipefd[1], &min_max, sizeof(struct MinMax));
                 }
                 return 0;
             }
+            child_pids[i] = child_pid;
         } else {
             printf("Fork failed!\n");
             return 1;
         }
     }
 
-    if (!with_files) {
+    if (mode == MODE_PIPE) {
         close(pipefd[1]);
     }
 
     // Основной цикл ожидания дочерних процессов
     while (active_child_processes > 0) {
-        pid_t pid = waitpid(-1, NULL, WNOHANG);
+        int status;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
         if (pid > 0) {
             active_child_processes--;
+            for (int j = 0; j < pnum; j++) {
+                if (child_pids[j] == pid) {
+                    child_done[j] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+                }
+            }
         }
 
         // Проверка флага таймаута
         if (timeout_flag) {
             // Отправляем SIGKILL всем дочерним процессам
             for (int j = 0; j < pnum; j++) {
-                kill(j, SIGKILL);
+                if (child_pids[j] > 0) {
+                    kill(child_pids[j], SIGKILL);
+                }
             }
             printf("Timeout reached! Child processes have been killed.\n");
             break;
@@ -178,8 +433,8 @@ int main(int argc, char **argv) {
         int min = INT_MAX;
         int max = INT_MIN;
 
-        if (with_files) {
-            char filename[16];
+        if (mode == MODE_FILES) {
+            char filename[32];
             snprintf(filename, sizeof(filename), "temp%d.txt", i);
             FILE *file = fopen(filename, "r");
             if (file == NULL) {
@@ -189,17 +444,23 @@ int main(int argc, char **argv) {
             fscanf(file, "%d %d", &min, &max);
             fclose(file);
             remove(filename);
-        } else {
+        } else if (mode == MODE_PIPE) {
             struct MinMax temp;
             read(pipefd[0], &temp, sizeof(struct MinMax));
             min = temp.min;
             max = temp.max;
+        } else if (mode == MODE_SHM && !child_done[i]) {
+            continue;
+        } else {
+            struct PaddedMinMax *slots = (mode == MODE_SHM) ? shm_results : results;
+            min = slots[i].value.min;
+            max = slots[i].value.max;
         }
         if (min < min_max.min) min_max.min = min;
         if (max > min_max.max) min_max.max = max;
     }
 
-    if (!with_files) {
+    if (mode == MODE_PIPE) {
         close(pipefd[0]);
     }
 
@@ -208,12 +469,31 @@ int main(int argc, char **argv) {
 
     double elapsed_time = (finish_time.tv_sec - start_time.tv_sec) * 1000.0;
     elapsed_time += (finish_time.tv_usec - start_time.tv_usec) / 1000.0;
+    elapsed_time += setup_time;
 
-    free(array);
+    if (pool != NULL) {
+        ThreadPoolDestroy(pool);
+    }
+    free(results);
+    free(child_pids);
+    free(child_done);
+    if (mode == MODE_SHM) {
+        munmap(shm_results, shm_size);
+    } else {
+        free(array);
+    }
 
     printf("Min: %d\n", min_max.min);
     printf("Max: %d\n", min_max.max);
     printf("Elapsed time: %fms\n", elapsed_time);
+    if (mode == MODE_THREADS) {
+        printf("Setup time: %fms\n", setup_time);
+    }
+    printf("Kernel: %s\n", GetMinMaxKernelName());
+    if (mode == MODE_THREADS && pin) {
+        PrintNodeThroughput(stats, pnum);
+    }
+    free(stats);
     fflush(NULL);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,153 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <limits.h>
+#include <sys/time.h>
+
+#include "reduce_stats.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+// Аргументы задачи для пула потоков
+struct StatsArgs {
+  const int *array;
+  uint32_t array_size;
+  uint32_t threads_num;
+  const struct StatsConfig *config;
+  struct Stats *results;  // По одному выровненному слоту на поток
+};
+
+static void ThreadStats(void *args, unsigned int worker) {
+  struct StatsArgs *sargs = (struct StatsArgs *)args;
+  size_t begin = (uint64_t)sargs->array_size * worker / sargs->threads_num;
+  size_t end = (uint64_t)sargs->array_size * (worker + 1) / sargs->threads_num;
+
+  StatsInit(&sargs->results[worker]);
+  StatsAccumulate(&sargs->results[worker], sargs->config, sargs->array, begin, end);
+}
+
+static void PrintUsage(const char *program) {
+  printf("Usage: %s --threads_num <num> --array_size <size> --seed <num> "
+         "[--stats min,max,sum,count,mean,variance,histogram|all] "
+         "[--hist_min <num>] [--hist_max <num>] [--buckets <num>]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t threads_num = 0;
+  uint32_t array_size = 0;
+  uint32_t seed = 0;
+  struct StatsConfig config = {STATS_ALL, 0, RAND_MAX, 16};
+
+  // Обработка аргументов командной строки
+  while (1) {
+    static struct option long_options[] = {
+      {"threads_num", required_argument, 0, 't'},
+      {"array_size", required_argument, 0, 'a'},
+      {"seed", required_argument, 0, 's'},
+      {"stats", required_argument, 0, 'S'},
+      {"hist_min", required_argument, 0, 'l'},
+      {"hist_max", required_argument, 0, 'h'},
+      {"buckets", required_argument, 0, 'b'},
+      {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    int c = getopt_long(argc, argv, "t:a:s:", long_options, &option_index);
+    if (c == -1)
+      break;
+
+    switch (c) {
+      case 't':
+        threads_num = atoi(optarg);
+        break;
+      case 'a':
+        array_size = atoi(optarg);
+        break;
+      case 's':
+        seed = atoi(optarg);
+        break;
+      case 'S':
+        if (!ParseStatsList(optarg, &config.flags)) {
+          printf("Error: unknown statistic in list %s\n", optarg);
+          return 1;
+        }
+        break;
+      case 'l':
+        config.hist_min = atoi(optarg);
+        break;
+      case 'h':
+        config.hist_max = atoi(optarg);
+        break;
+      case 'b':
+        config.buckets = atoi(optarg);
+        break;
+      default:
+        PrintUsage(argv[0]);
+        return 1;
+    }
+  }
+
+  // Проверка на правильность ввода
+  if (threads_num == 0 || array_size == 0 || seed == 0) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  if (config.buckets == 0 || config.buckets > STATS_MAX_BUCKETS ||
+      config.hist_min > config.hist_max) {
+    printf("Error: need 1..%d buckets and hist_min <= hist_max\n", STATS_MAX_BUCKETS);
+    return 1;
+  }
+  // Дисперсия считается вместе со средним
+  if (config.flags & STATS_VARIANCE) {
+    config.flags |= STATS_MEAN;
+  }
+
+  int *array = malloc(sizeof(int) * array_size);
+  struct Stats *results = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct Stats) * threads_num);
+  struct ThreadPool *pool = ThreadPoolCreate(threads_num);
+  if (array == NULL || results == NULL || pool == NULL) {
+    printf("Error: unable to allocate memory or create threads\n");
+    return 1;
+  }
+  GenerateArray(array, array_size, seed);
+
+  struct timeval start_time;
+  gettimeofday(&start_time, NULL);
+
+  // Каждый поток считает все статистики по своей части за один проход
+  struct StatsArgs args = {array, array_size, threads_num, &config, results};
+  ThreadPoolRun(pool, ThreadStats, &args);
+
+  struct Stats total;
+  StatsInit(&total);
+  for (uint32_t i = 0; i < threads_num; i++) {
+    StatsMerge(&total, &results[i]);
+  }
+
+  struct timeval finish_time;
+  gettimeofday(&finish_time, NULL);
+
+  double elapsed_time = (finish_time.tv_sec - start_time.tv_sec) * 1000.0;
+  elapsed_time += (finish_time.tv_usec - start_time.tv_usec) / 1000.0;
+
+  if (config.flags & STATS_MIN) printf("Min: %d\n", total.min);
+  if (config.flags & STATS_MAX) printf("Max: %d\n", total.max);
+  if (config.flags & STATS_SUM) printf("Sum: %lld\n", (long long)total.sum);
+  if (config.flags & STATS_COUNT) printf("Count: %llu\n", (unsigned long long)total.count);
+  if (config.flags & STATS_MEAN) printf("Mean: %f\n", total.mean);
+  if (config.flags & STATS_VARIANCE) printf("Variance: %f\n", StatsVariance(&total));
+  if (config.flags & STATS_HISTOGRAM) {
+    printf("Histogram:");
+    for (unsigned int i = 0; i < config.buckets; i++) {
+      printf(" %llu", (unsigned long long)total.histogram[i]);
+    }
+    printf("\n");
+  }
+  printf("Elapsed time: %fms\n", elapsed_time);
+
+  ThreadPoolDestroy(pool);
+  free(results);
+  free(array);
+  return 0;
+}
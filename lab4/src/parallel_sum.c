@@ -1,33 +1,230 @@
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <getopt.h>
 #include <time.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SUM_X86 1
+#endif
+
+#include "affinity.h"
+#include "schedule.h"
+#include "utils.h"
+
+// Способ накопления суммы
+enum Accumulator {
+  ACCUM_INT64,   // Точная сумма в int64_t
+  ACCUM_INT128,  // Суммы блоков в int64_t, итог в __int128: не переполняется
+  ACCUM_KAHAN    // double с компенсацией ошибки округления (Кэхэн-Ноймайер)
+};
+
 struct SumArgs {
   int *array;
-  int begin;
-  int end;
+  size_t begin;
+  size_t end;
+};
+
+// Результат потока, в отдельной кэш-линии
+struct SumResult {
+  int64_t sum;
+  __int128 wide_sum;
+  double kahan_sum;
+  double kahan_compensation;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+// Аргументы потока: блоки для суммирования выдает планировщик
+struct ThreadArgs {
+  int *array;
+  struct ChunkScheduler *scheduler;
+  unsigned int worker;
+  enum Accumulator accumulator;
+  struct SumResult *result;
+
+  // Размещение по NUMA-узлам: поток привязывается к процессору и сам
+  // заполняет (первым касается) свою часть массива
+  bool pin;
+  bool numa;
+  uint32_t seed;
+  size_t array_size;
+  unsigned int threads_num;
+  pthread_barrier_t *start;    // Все потоки готовы - начинается замер
+  struct WorkerStats *stats;
+  double start_ms;             // Момент начала суммирования в потоке
 };
 
-int Sum(const struct SumArgs *args) {
-  int sum = 0;
-  for (int i = args->begin; i < args->end; i++) {
+// Эталонная скалярная сумма с расширением до int64_t
+int64_t SumScalar(const struct SumArgs *args) {
+  int64_t sum = 0;
+  for (size_t i = args->begin; i < args->end; i++) {
     sum += args->array[i];
   }
   return sum;
 }
 
+#ifdef SUM_X86
+// int32 расширяются до int64 и складываются в четырех независимых регистрах
+__attribute__((target("avx2")))
+static int64_t SumAVX2(const struct SumArgs *args) {
+  const int *array = args->array;
+  __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+  size_t i = args->begin;
+
+  for (; args->end - i >= 16; i += 16) {
+    acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(
+                                      _mm_loadu_si128((const __m128i *)(array + i))));
+    acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(
+                                      _mm_loadu_si128((const __m128i *)(array + i + 4))));
+    acc2 = _mm256_add_epi64(acc2, _mm256_cvtepi32_epi64(
+                                      _mm_loadu_si128((const __m128i *)(array + i + 8))));
+    acc3 = _mm256_add_epi64(acc3, _mm256_cvtepi32_epi64(
+                                      _mm_loadu_si128((const __m128i *)(array + i + 12))));
+  }
+
+  __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+
+  struct SumArgs tail = {args->array, i, args->end};
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumScalar(&tail);
+}
+#endif
+
+static int64_t (*sum_kernel)(const struct SumArgs *args) = SumScalar;
+static const char *sum_kernel_name = "scalar";
+
+int64_t Sum(const struct SumArgs *args) {
+  return sum_kernel(args);
+}
+
+// Сложение с компенсацией: ошибка округления копится в compensation
+static void KahanAdd(double *sum, double *compensation, double value) {
+  double t = *sum + value;
+  if ((*sum >= 0 ? *sum : -*sum) >= (value >= 0 ? value : -value)) {
+    *compensation += (*sum - t) + value;
+  } else {
+    *compensation += (value - t) + *sum;
+  }
+  *sum = t;
+}
+
+static double NowMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
 void *ThreadSum(void *args) {
-  struct SumArgs *sum_args = (struct SumArgs *)args;
-  return (void *)(size_t)Sum(sum_args);
+  struct ThreadArgs *thread_args = (struct ThreadArgs *)args;
+  struct SumResult result = {0, 0, 0, 0};
+  size_t begin, end;
+  uint64_t bytes = 0;
+
+  if (thread_args->pin) {
+    PinToCpu(thread_args->worker);
+  }
+  // Страницы попадают на узел потока, который коснулся их первым: поток
+  // заполняет ту же часть, что получит при статическом планировании
+  if (thread_args->numa) {
+    size_t first = thread_args->array_size * thread_args->worker / thread_args->threads_num;
+    size_t last = thread_args->array_size * (thread_args->worker + 1) / thread_args->threads_num;
+    GenerateArrayRange(thread_args->array, first, last, thread_args->seed);
+  }
+  pthread_barrier_wait(thread_args->start);
+  double start_ms = NowMs();
+  thread_args->start_ms = start_ms;
+
+  // Поток берет блоки, пока массив не закончится. Блок меньше 2^32
+  // элементов, поэтому его сумма в int64_t не переполняется.
+  while (SchedulerNext(thread_args->scheduler, thread_args->worker, &begin, &end)) {
+    struct SumArgs sum_args = {thread_args->array, begin, end};
+    bytes += (end - begin) * sizeof(int);
+    if (thread_args->accumulator == ACCUM_KAHAN) {
+      for (size_t i = begin; i < end; i++) {
+        KahanAdd(&result.kahan_sum, &result.kahan_compensation, thread_args->array[i]);
+      }
+    } else {
+      int64_t sum = Sum(&sum_args);
+      result.sum += sum;
+      result.wide_sum += sum;
+    }
+  }
+
+  *thread_args->result = result;
+  thread_args->stats->node = CurrentNumaNode();
+  thread_args->stats->bytes = bytes;
+  thread_args->stats->elapsed_ms = NowMs() - start_ms;
+  return NULL;
+}
+
+// Десятичная запись __int128 (printf ее не поддерживает)
+static void FormatInt128(__int128 value, char *buf, size_t size) {
+  char digits[48];
+  size_t len = 0;
+  bool negative = value < 0;
+  unsigned __int128 magnitude = negative ? -(unsigned __int128)value : (unsigned __int128)value;
+  do {
+    digits[len++] = (char)('0' + (int)(magnitude % 10));
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  size_t pos = 0;
+  if (negative && pos + 1 < size) buf[pos++] = '-';
+  while (len > 0 && pos + 1 < size) buf[pos++] = digits[--len];
+  buf[pos] = '\0';
+}
+
+static bool ParseAccumulator(const char *name, enum Accumulator *accumulator) {
+  if (strcmp(name, "int64") == 0) {
+    *accumulator = ACCUM_INT64;
+  } else if (strcmp(name, "int128") == 0) {
+    *accumulator = ACCUM_INT128;
+  } else if (strcmp(name, "kahan") == 0) {
+    *accumulator = ACCUM_KAHAN;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool SetSumKernel(const char *name) {
+#ifdef SUM_X86
+  if ((strcmp(name, "auto") == 0 || strcmp(name, "avx2") == 0) &&
+      __builtin_cpu_supports("avx2")) {
+    sum_kernel = SumAVX2;
+    sum_kernel_name = "avx2";
+    return true;
+  }
+#endif
+  if (strcmp(name, "auto") == 0 || strcmp(name, "scalar") == 0) {
+    sum_kernel = SumScalar;
+    sum_kernel_name = "scalar";
+    return true;
+  }
+  return false;
+}
+
+static void PrintUsage(const char *program) {
+  printf("Usage: %s --threads_num <num> --array_size <size> --seed <num> "
+         "[--schedule static|dynamic|steal] [--chunk_size <num>] "
+         "[--accum int64|int128|kahan] [--kernel auto|avx2|scalar] [--numa] [--pin]\n", program);
 }
 
 int main(int argc, char *argv[]) {
   uint32_t threads_num = 0;
   uint32_t array_size = 0;
   uint32_t seed = 0;
+  enum ScheduleKind schedule = SCHEDULE_STATIC;
+  uint32_t chunk_size = 16384;  // 64 КБ - блок помещается в L2
+  enum Accumulator accumulator = ACCUM_INT64;
+  bool numa = false;  // Каждый поток сам размещает свою часть массива
+  bool pin = false;   // Потоки привязываются к процессорам
+
+  SetSumKernel("auto");
 
   // Обработка аргументов командной строки
   while (1) {
@@ -35,6 +232,12 @@ int main(int argc, char *argv[]) {
       {"threads_num", required_argument, 0, 't'},
       {"array_size", required_argument, 0, 'a'},
       {"seed", required_argument, 0, 's'},
+      {"schedule", required_argument, 0, 'S'},
+      {"chunk_size", required_argument, 0, 'c'},
+      {"accum", required_argument, 0, 'A'},
+      {"kernel", required_argument, 0, 'k'},
+      {"numa", no_argument, 0, 'N'},
+      {"pin", no_argument, 0, 'P'},
       {0, 0, 0, 0}
     };
 
@@ -53,50 +256,100 @@ int main(int argc, char *argv[]) {
       case 's':
         seed = atoi(optarg);
         break;
+      case 'S':
+        if (!ParseSchedule(optarg, &schedule)) {
+          printf("Schedule should be one of: static, dynamic, steal\n");
+          return 1;
+        }
+        break;
+      case 'c':
+        chunk_size = atoi(optarg);
+        break;
+      case 'A':
+        if (!ParseAccumulator(optarg, &accumulator)) {
+          printf("Accumulator should be one of: int64, int128, kahan\n");
+          return 1;
+        }
+        break;
+      case 'k':
+        if (!SetSumKernel(optarg)) {
+          printf("Kernel %s is unknown or not supported by this CPU\n", optarg);
+          return 1;
+        }
+        break;
+      case 'N':
+        numa = true;
+        break;
+      case 'P':
+        pin = true;
+        break;
       default:
-        printf("Usage: %s --threads_num <num> --array_size <size> --seed <num>\n", argv[0]);
+        PrintUsage(argv[0]);
         return 1;
     }
   }
 
   // Проверка на правильность ввода
-  if (threads_num == 0 || array_size == 0 || seed == 0) {
-    printf("Usage: %s --threads_num <num> --array_size <size> --seed <num>\n", argv[0]);
+  if (threads_num == 0 || array_size == 0 || seed == 0 || chunk_size == 0) {
+    PrintUsage(argv[0]);
     return 1;
   }
 
-  // Инициализация массива и генерация случайных чисел
+  // Без привязки первое касание страницы не гарантирует нужный узел
+  if (numa) {
+    pin = true;
+  }
+  AffinityInit();
+
+  // Инициализация массива и генерация случайных чисел во всем диапазоне
+  // [0, RAND_MAX]: сумма накапливается в 64 битах и не переполняется.
+  // С --numa массив заполняют сами потоки, каждый свою часть.
   int *array = malloc(sizeof(int) * array_size);
   if (array == NULL) {
     printf("Error: unable to allocate memory for array\n");
     return 1;
   }
-  
-  srand(seed);
-  for (uint32_t i = 0; i < array_size; i++) {
-    array[i] = rand() % 100; // Числа в диапазоне от 0 до 99
+  if (!numa) {
+    GenerateArray(array, array_size, seed);
+  }
+  // При --numa потоки должны суммировать те же части, что заполнили
+  if (numa && schedule != SCHEDULE_STATIC) {
+    printf("Warning: --numa keeps pages local only with --schedule static\n");
   }
 
   // Динамическое выделение памяти для потоков и аргументов
   pthread_t *threads = malloc(sizeof(pthread_t) * threads_num);
-  struct SumArgs *args = malloc(sizeof(struct SumArgs) * threads_num);
+  struct ThreadArgs *args = malloc(sizeof(struct ThreadArgs) * threads_num);
+  struct SumResult *results = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct SumResult) * threads_num);
+  struct WorkerStats *stats = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct WorkerStats) * threads_num);
+  struct ChunkScheduler *scheduler =
+      SchedulerCreate(schedule, array_size, chunk_size, threads_num);
 
-  if (threads == NULL || args == NULL) {
+  if (threads == NULL || args == NULL || results == NULL || stats == NULL ||
+      scheduler == NULL) {
     printf("Error: unable to allocate memory for threads or args\n");
     free(array);
     return 1;
   }
 
-  // Разбиение массива на части для потоков
-  uint32_t chunk_size = array_size / threads_num;
+  pthread_barrier_t start;
+  pthread_barrier_init(&start, NULL, threads_num + 1);
+
+  // Части массива раздает планировщик: static - по одной равной части
+  // на поток, dynamic и steal - блоками chunk_size до исчерпания массива
   for (uint32_t i = 0; i < threads_num; i++) {
     args[i].array = array;
-    args[i].begin = i * chunk_size;
-    if (i == threads_num - 1) {
-      args[i].end = array_size;  // Последний поток обрабатывает остаток
-    } else {
-      args[i].end = (i + 1) * chunk_size;
-    }
+    args[i].scheduler = scheduler;
+    args[i].worker = i;
+    args[i].accumulator = accumulator;
+    args[i].result = &results[i];
+    args[i].pin = pin;
+    args[i].numa = numa;
+    args[i].seed = seed;
+    args[i].array_size = array_size;
+    args[i].threads_num = threads_num;
+    args[i].start = &start;
+    args[i].stats = &stats[i];
     if (pthread_create(&threads[i], NULL, ThreadSum, (void *)&args[i])) {
       printf("Error: pthread_create failed!\n");
       free(array);
@@ -106,19 +359,49 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // Замер начинается, когда все потоки созданы (и разместили свои части):
+  // за начало берется самый ранний старт суммирования среди потоков
+  pthread_barrier_wait(&start);
+
   // Сбор результатов от потоков
-  int total_sum = 0;
+  struct SumResult total = {0, 0, 0, 0};
   for (uint32_t i = 0; i < threads_num; i++) {
-    void *sum_ptr;
-    pthread_join(threads[i], &sum_ptr);
-    int sum = (int)(size_t)sum_ptr;
-    total_sum += sum;
+    pthread_join(threads[i], NULL);
+    total.sum += results[i].sum;
+    total.wide_sum += results[i].wide_sum;
+    KahanAdd(&total.kahan_sum, &total.kahan_compensation, results[i].kahan_sum);
+    KahanAdd(&total.kahan_sum, &total.kahan_compensation, results[i].kahan_compensation);
   }
 
+  // Замер времени выполнения суммирования
+  double start_ms = args[0].start_ms;
+  for (uint32_t i = 1; i < threads_num; i++) {
+    if (args[i].start_ms < start_ms) start_ms = args[i].start_ms;
+  }
+  double elapsed_time = NowMs() - start_ms;
+
+  pthread_barrier_destroy(&start);
+  SchedulerDestroy(scheduler);
   free(array);
   free(threads);
   free(args);
+  free(results);
 
-  printf("Total sum: %d\n", total_sum);
+  if (accumulator == ACCUM_INT128) {
+    char buf[48];
+    FormatInt128(total.wide_sum, buf, sizeof(buf));
+    printf("Total sum: %s\n", buf);
+  } else if (accumulator == ACCUM_KAHAN) {
+    printf("Total sum: %.1f\n", total.kahan_sum + total.kahan_compensation);
+  } else {
+    printf("Total sum: %lld\n", (long long)total.sum);
+  }
+  printf("Elapsed time: %fms\n", elapsed_time);
+  // Kahan складывает поэлементно и ядро не использует
+  printf("Kernel: %s\n", accumulator == ACCUM_KAHAN ? "scalar" : sum_kernel_name);
+  if (pin) {
+    PrintNodeThroughput(stats, threads_num);
+  }
+  free(stats);
   return 0;
 }
\ No newline at end of file
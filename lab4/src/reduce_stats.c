@@ -0,0 +1,125 @@
+#include "reduce_stats.h"
+
+#include <limits.h>
+#include <string.h>
+
+// Блок обрабатывается целиком в кэше: первый проход считает min/max/sum и
+// гистограмму, второй - отклонения от среднего блока для дисперсии. Из памяти
+// каждый элемент читается один раз, а блоки сливаются формулой Чана.
+#define STATS_BLOCK 4096
+
+void StatsInit(struct Stats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->min = INT_MAX;
+  stats->max = INT_MIN;
+}
+
+static void AccumulateBlock(struct Stats *block, const struct StatsConfig *config,
+                            const int *values, size_t n) {
+  int min = INT_MAX;
+  int max = INT_MIN;
+  int64_t sum = 0;
+
+  // Без ветвлений по данным, чтобы компилятор мог векторизовать цикл
+  for (size_t i = 0; i < n; i++) {
+    int v = values[i];
+    min = v < min ? v : min;
+    max = v > max ? v : max;
+    sum += v;
+  }
+
+  block->min = min;
+  block->max = max;
+  block->sum = sum;
+  block->count = n;
+  block->mean = (double)sum / n;
+
+  if (config->flags & STATS_VARIANCE) {
+    double m2 = 0;
+    for (size_t i = 0; i < n; i++) {
+      double d = values[i] - block->mean;
+      m2 += d * d;
+    }
+    block->m2 = m2;
+  }
+
+  if (config->flags & STATS_HISTOGRAM) {
+    int64_t lo = config->hist_min;
+    double scale = (double)config->buckets / ((int64_t)config->hist_max - lo + 1);
+    unsigned int last = config->buckets - 1;
+    for (size_t i = 0; i < n; i++) {
+      int64_t offset = values[i] - lo;
+      unsigned int bucket;
+      if (offset < 0) {
+        bucket = 0;
+      } else {
+        bucket = (unsigned int)(offset * scale);
+        if (bucket > last) bucket = last;
+      }
+      block->histogram[bucket]++;
+    }
+  }
+}
+
+void StatsAccumulate(struct Stats *stats, const struct StatsConfig *config,
+                     const int *array, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i += STATS_BLOCK) {
+    size_t n = end - i < STATS_BLOCK ? end - i : STATS_BLOCK;
+    struct Stats block;
+    memset(block.histogram, 0, sizeof(block.histogram));
+    block.m2 = 0;
+    AccumulateBlock(&block, config, array + i, n);
+    StatsMerge(stats, &block);
+  }
+}
+
+void StatsMerge(struct Stats *acc, const struct Stats *part) {
+  if (part->count == 0) return;
+
+  if (part->min < acc->min) acc->min = part->min;
+  if (part->max > acc->max) acc->max = part->max;
+  acc->sum += part->sum;
+
+  // Параллельное объединение среднего и m2 (Chan et al.)
+  uint64_t count = acc->count + part->count;
+  double delta = part->mean - acc->mean;
+  acc->mean += delta * part->count / count;
+  acc->m2 += part->m2 + delta * delta * ((double)acc->count * part->count / count);
+  acc->count = count;
+
+  for (unsigned int i = 0; i < STATS_MAX_BUCKETS; i++) {
+    acc->histogram[i] += part->histogram[i];
+  }
+}
+
+double StatsVariance(const struct Stats *stats) {
+  return stats->count > 0 ? stats->m2 / stats->count : 0;
+}
+
+bool ParseStatsList(const char *list, unsigned int *flags) {
+  static const struct {
+    const char *name;
+    unsigned int flag;
+  } kNames[] = {
+    {"min", STATS_MIN},         {"max", STATS_MAX},
+    {"sum", STATS_SUM},         {"count", STATS_COUNT},
+    {"mean", STATS_MEAN},       {"variance", STATS_VARIANCE},
+    {"histogram", STATS_HISTOGRAM}, {"all", STATS_ALL},
+  };
+
+  *flags = 0;
+  while (*list != '\0') {
+    size_t len = strcspn(list, ",");
+    bool found = false;
+    for (size_t i = 0; i < sizeof(kNames) / sizeof(kNames[0]); i++) {
+      if (strlen(kNames[i].name) == len && strncmp(list, kNames[i].name, len) == 0) {
+        *flags |= kNames[i].flag;
+        found = true;
+      }
+    }
+    if (!found) return false;
+    list += len;
+    if (*list == ',') list++;
+  }
+  return *flags != 0;
+}
@@ -0,0 +1,61 @@
+#ifndef REDUCE_STATS_H
+#define REDUCE_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+// Набор вычисляемых статистик
+enum StatsFlags {
+  STATS_MIN = 1 << 0,
+  STATS_MAX = 1 << 1,
+  STATS_SUM = 1 << 2,
+  STATS_COUNT = 1 << 3,
+  STATS_MEAN = 1 << 4,
+  STATS_VARIANCE = 1 << 5,
+  STATS_HISTOGRAM = 1 << 6,
+  STATS_ALL = (1 << 7) - 1
+};
+
+#define STATS_MAX_BUCKETS 64
+
+struct StatsConfig {
+  unsigned int flags;
+  // Гистограмма: buckets равных корзин на [hist_min, hist_max];
+  // значения вне диапазона попадают в крайние корзины
+  int hist_min;
+  int hist_max;
+  unsigned int buckets;
+};
+
+// Частичный результат: считается по части массива и объединяется с другими
+struct Stats {
+  int min;
+  int max;
+  int64_t sum;
+  uint64_t count;
+  // Среднее и сумма квадратов отклонений: в блоке - двумя проходами,
+  // между блоками и частями - формулой Чана
+  double mean;
+  double m2;
+  uint64_t histogram[STATS_MAX_BUCKETS];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+void StatsInit(struct Stats *stats);
+
+// Добавляет к stats элементы [begin, end) за один проход по памяти
+void StatsAccumulate(struct Stats *stats, const struct StatsConfig *config,
+                     const int *array, size_t begin, size_t end);
+
+// Объединяет частичный результат part с acc
+void StatsMerge(struct Stats *acc, const struct Stats *part);
+
+// Дисперсия генеральной совокупности (m2 / count)
+double StatsVariance(const struct Stats *stats);
+
+// Разбор списка вида "min,max,sum" или "all"
+bool ParseStatsList(const char *list, unsigned int *flags);
+
+#endif
@@ -0,0 +1,173 @@
+#include "schedule.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+// Очередь блоков одного потока: номера блоков [lo, hi)
+struct StealQueue {
+  pthread_mutex_t mutex;
+  size_t lo;
+  size_t hi;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct ChunkScheduler {
+  enum ScheduleKind kind;
+  size_t total;
+  size_t chunk_size;
+  unsigned int threads;
+
+  // SCHEDULE_DYNAMIC: следующий свободный элемент, в отдельной кэш-линии
+  _Alignas(CACHE_LINE_SIZE) atomic_size_t next;
+
+  // SCHEDULE_STATIC: выдал ли поток свою часть
+  bool *static_done;
+
+  // SCHEDULE_STEAL: очереди потоков
+  struct StealQueue *queues;
+};
+
+bool ParseSchedule(const char *name, enum ScheduleKind *kind) {
+  if (strcmp(name, "static") == 0) {
+    *kind = SCHEDULE_STATIC;
+  } else if (strcmp(name, "dynamic") == 0) {
+    *kind = SCHEDULE_DYNAMIC;
+  } else if (strcmp(name, "steal") == 0) {
+    *kind = SCHEDULE_STEAL;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+struct ChunkScheduler *SchedulerCreate(enum ScheduleKind kind, size_t total,
+                                       size_t chunk_size, unsigned int threads) {
+  struct ChunkScheduler *scheduler = aligned_alloc(CACHE_LINE_SIZE, sizeof(*scheduler));
+  if (scheduler == NULL) return NULL;
+  memset(scheduler, 0, sizeof(*scheduler));
+
+  scheduler->kind = kind;
+  scheduler->total = total;
+  scheduler->chunk_size = chunk_size > 0 ? chunk_size : 1;
+  scheduler->threads = threads;
+  atomic_init(&scheduler->next, 0);
+
+  if (kind == SCHEDULE_STATIC) {
+    scheduler->static_done = calloc(threads, sizeof(bool));
+    if (scheduler->static_done == NULL) {
+      free(scheduler);
+      return NULL;
+    }
+  } else if (kind == SCHEDULE_STEAL) {
+    scheduler->queues = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct StealQueue) * threads);
+    if (scheduler->queues == NULL) {
+      free(scheduler);
+      return NULL;
+    }
+    // Блоки изначально делятся между потоками поровну
+    size_t chunks = (total + scheduler->chunk_size - 1) / scheduler->chunk_size;
+    for (unsigned int i = 0; i < threads; i++) {
+      pthread_mutex_init(&scheduler->queues[i].mutex, NULL);
+      scheduler->queues[i].lo = chunks * i / threads;
+      scheduler->queues[i].hi = chunks * (i + 1) / threads;
+    }
+  }
+  return scheduler;
+}
+
+// Перевод номера блока в диапазон элементов
+static void ChunkRange(const struct ChunkScheduler *scheduler, size_t chunk,
+                       size_t *begin, size_t *end) {
+  *begin = chunk * scheduler->chunk_size;
+  *end = *begin + scheduler->chunk_size;
+  if (*end > scheduler->total) *end = scheduler->total;
+}
+
+static bool NextStatic(struct ChunkScheduler *scheduler, unsigned int worker,
+                       size_t *begin, size_t *end) {
+  if (scheduler->static_done[worker]) return false;
+  scheduler->static_done[worker] = true;
+
+  *begin = scheduler->total * worker / scheduler->threads;
+  *end = scheduler->total * (worker + 1) / scheduler->threads;
+  return *begin < *end;
+}
+
+static bool NextDynamic(struct ChunkScheduler *scheduler, size_t *begin, size_t *end) {
+  size_t start = atomic_fetch_add_explicit(&scheduler->next, scheduler->chunk_size,
+                                           memory_order_relaxed);
+  if (start >= scheduler->total) return false;
+
+  *begin = start;
+  *end = start + scheduler->chunk_size;
+  if (*end > scheduler->total) *end = scheduler->total;
+  return true;
+}
+
+static bool NextSteal(struct ChunkScheduler *scheduler, unsigned int worker,
+                      size_t *begin, size_t *end) {
+  struct StealQueue *own = &scheduler->queues[worker];
+
+  // Сначала берем блок из начала своей очереди
+  pthread_mutex_lock(&own->mutex);
+  if (own->lo < own->hi) {
+    size_t chunk = own->lo++;
+    pthread_mutex_unlock(&own->mutex);
+    ChunkRange(scheduler, chunk, begin, end);
+    return true;
+  }
+  pthread_mutex_unlock(&own->mutex);
+
+  // Своя очередь пуста: крадем половину хвоста у первого непустого соседа
+  for (unsigned int i = 1; i < scheduler->threads; i++) {
+    struct StealQueue *victim = &scheduler->queues[(worker + i) % scheduler->threads];
+
+    pthread_mutex_lock(&victim->mutex);
+    size_t left = victim->hi - victim->lo;
+    if (left == 0) {
+      pthread_mutex_unlock(&victim->mutex);
+      continue;
+    }
+    size_t stolen_lo = victim->hi - (left + 1) / 2;
+    size_t stolen_hi = victim->hi;
+    victim->hi = stolen_lo;
+    pthread_mutex_unlock(&victim->mutex);
+
+    // Первый украденный блок обрабатываем сразу, остальные кладем к себе
+    pthread_mutex_lock(&own->mutex);
+    own->lo = stolen_lo + 1;
+    own->hi = stolen_hi;
+    pthread_mutex_unlock(&own->mutex);
+
+    ChunkRange(scheduler, stolen_lo, begin, end);
+    return true;
+  }
+  return false;
+}
+
+bool SchedulerNext(struct ChunkScheduler *scheduler, unsigned int worker,
+                   size_t *begin, size_t *end) {
+  switch (scheduler->kind) {
+    case SCHEDULE_STATIC:
+      return NextStatic(scheduler, worker, begin, end);
+    case SCHEDULE_DYNAMIC:
+      return NextDynamic(scheduler, begin, end);
+    case SCHEDULE_STEAL:
+      return NextSteal(scheduler, worker, begin, end);
+  }
+  return false;
+}
+
+void SchedulerDestroy(struct ChunkScheduler *scheduler) {
+  if (scheduler->queues != NULL) {
+    for (unsigned int i = 0; i < scheduler->threads; i++) {
+      pthread_mutex_destroy(&scheduler->queues[i].mutex);
+    }
+  }
+  free(scheduler->queues);
+  free(scheduler->static_done);
+  free(scheduler);
+}
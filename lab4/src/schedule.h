@@ -0,0 +1,28 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Способ раздачи частей массива потокам
+enum ScheduleKind {
+  SCHEDULE_STATIC,   // Каждый поток получает одну равную часть
+  SCHEDULE_DYNAMIC,  // Общий атомарный счетчик блоков
+  SCHEDULE_STEAL     // Свои очереди блоков, опустевший поток крадет половину чужой
+};
+
+struct ChunkScheduler;
+
+bool ParseSchedule(const char *name, enum ScheduleKind *kind);
+
+// total элементов делятся на блоки по chunk_size между threads потоками
+struct ChunkScheduler *SchedulerCreate(enum ScheduleKind kind, size_t total,
+                                       size_t chunk_size, unsigned int threads);
+
+// Следующий диапазон [begin, end) для потока worker; false - работа закончилась
+bool SchedulerNext(struct ChunkScheduler *scheduler, unsigned int worker,
+                   size_t *begin, size_t *end);
+
+void SchedulerDestroy(struct ChunkScheduler *scheduler);
+
+#endif
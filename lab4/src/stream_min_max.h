@@ -0,0 +1,25 @@
+#ifndef STREAM_MIN_MAX_H
+#define STREAM_MIN_MAX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+// Формат входных данных
+enum InputFormat {
+  INPUT_BINARY,  // Подряд идущие int32 в порядке байт машины
+  INPUT_TEXT     // Десятичные числа, разделенные пробельными символами
+};
+
+// Разбор имени формата: "bin" или "text"
+bool ParseInputFormat(const char *name, enum InputFormat *format);
+
+// Поиск min/max по данным из файла или stdin (path == "-") без загрузки в память.
+// Обычный бинарный файл отображается через mmap и делится между threads
+// потоками по границам страниц; остальные входы читаются блоками.
+// Возвращает 0 при успехе и -1 при ошибке (сообщение уже выведено).
+int MinMaxFromInput(const char *path, enum InputFormat format, unsigned int threads,
+                    struct MinMax *min_max, uint64_t *count);
+
+#endif
@@ -0,0 +1,151 @@
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reduce_stats.h"
+#include "utils.h"
+
+#define ARRAY_SIZE 100003
+
+static const struct StatsConfig kConfig = {STATS_ALL, -1000, 1000, 16};
+
+// Эталон: обычные два прохода по всему массиву
+static void ReferenceStats(const int *array, size_t n, double *mean, double *variance) {
+  double sum = 0;
+  for (size_t i = 0; i < n; i++) sum += array[i];
+  *mean = sum / n;
+  double m2 = 0;
+  for (size_t i = 0; i < n; i++) m2 += (array[i] - *mean) * (array[i] - *mean);
+  *variance = m2 / n;
+}
+
+void testSmallArray(void) {
+  int array[] = {1, 2, 3, 4};
+  struct StatsConfig config = {STATS_ALL, 1, 4, 4};
+  struct Stats stats;
+  StatsInit(&stats);
+  StatsAccumulate(&stats, &config, array, 0, 4);
+
+  CU_ASSERT_EQUAL(stats.min, 1);
+  CU_ASSERT_EQUAL(stats.max, 4);
+  CU_ASSERT_EQUAL(stats.sum, 10);
+  CU_ASSERT_EQUAL(stats.count, 4);
+  CU_ASSERT_DOUBLE_EQUAL(stats.mean, 2.5, 1e-12);
+  CU_ASSERT_DOUBLE_EQUAL(StatsVariance(&stats), 1.25, 1e-12);
+  for (int i = 0; i < 4; i++) CU_ASSERT_EQUAL(stats.histogram[i], 1);
+}
+
+void testHistogramEdges(void) {
+  // Значения вне [hist_min, hist_max] попадают в крайние корзины
+  int array[] = {-50, 0, 9, 10, 19, 500};
+  struct StatsConfig config = {STATS_HISTOGRAM, 0, 19, 2};
+  struct Stats stats;
+  StatsInit(&stats);
+  StatsAccumulate(&stats, &config, array, 0, 6);
+
+  CU_ASSERT_EQUAL(stats.histogram[0], 3);
+  CU_ASSERT_EQUAL(stats.histogram[1], 3);
+}
+
+void testMergeMatchesSinglePass(void) {
+  int *array = malloc(sizeof(int) * ARRAY_SIZE);
+  CU_ASSERT_PTR_NOT_NULL_FATAL(array);
+  GenerateArray(array, ARRAY_SIZE, 42);
+  for (size_t i = 0; i < ARRAY_SIZE; i++) array[i] = array[i] % 3000 - 1500;
+
+  struct Stats single;
+  StatsInit(&single);
+  StatsAccumulate(&single, &kConfig, array, 0, ARRAY_SIZE);
+
+  // Неравные части, в том числе пустая и короче блока, сливаются по одной
+  size_t bounds[] = {0, 1, 1, 4095, 4097, 50000, 99999, ARRAY_SIZE};
+  struct Stats merged;
+  StatsInit(&merged);
+  for (size_t i = 0; i + 1 < sizeof(bounds) / sizeof(bounds[0]); i++) {
+    struct Stats part;
+    StatsInit(&part);
+    StatsAccumulate(&part, &kConfig, array, bounds[i], bounds[i + 1]);
+    StatsMerge(&merged, &part);
+  }
+
+  double mean, variance;
+  ReferenceStats(array, ARRAY_SIZE, &mean, &variance);
+
+  CU_ASSERT_EQUAL(merged.min, single.min);
+  CU_ASSERT_EQUAL(merged.max, single.max);
+  CU_ASSERT_EQUAL(merged.sum, single.sum);
+  CU_ASSERT_EQUAL(merged.count, ARRAY_SIZE);
+  CU_ASSERT_EQUAL(single.count, ARRAY_SIZE);
+  CU_ASSERT_DOUBLE_EQUAL(single.mean, mean, 1e-9);
+  CU_ASSERT_DOUBLE_EQUAL(merged.mean, mean, 1e-9);
+  CU_ASSERT_DOUBLE_EQUAL(StatsVariance(&single), variance, variance * 1e-9);
+  CU_ASSERT_DOUBLE_EQUAL(StatsVariance(&merged), variance, variance * 1e-9);
+  CU_ASSERT_EQUAL(memcmp(merged.histogram, single.histogram, sizeof(single.histogram)), 0);
+
+  free(array);
+}
+
+void testMergeEmpty(void) {
+  int array[] = {7, -3};
+  struct Stats stats, empty;
+  StatsInit(&stats);
+  StatsInit(&empty);
+  StatsAccumulate(&stats, &kConfig, array, 0, 2);
+  StatsMerge(&stats, &empty);
+
+  CU_ASSERT_EQUAL(stats.count, 2);
+  CU_ASSERT_EQUAL(stats.min, -3);
+  CU_ASSERT_EQUAL(stats.max, 7);
+  CU_ASSERT_DOUBLE_EQUAL(stats.mean, 2.0, 1e-12);
+  CU_ASSERT_DOUBLE_EQUAL(StatsVariance(&stats), 25.0, 1e-12);
+
+  // Пустой результат, в который слили непустой, равен непустому
+  StatsMerge(&empty, &stats);
+  CU_ASSERT_EQUAL(empty.count, 2);
+  CU_ASSERT_EQUAL(empty.min, -3);
+  CU_ASSERT_DOUBLE_EQUAL(StatsVariance(&empty), 25.0, 1e-12);
+}
+
+void testParseStatsList(void) {
+  unsigned int flags;
+  CU_ASSERT_TRUE(ParseStatsList("min,variance", &flags));
+  CU_ASSERT_EQUAL(flags, STATS_MIN | STATS_VARIANCE);
+  CU_ASSERT_TRUE(ParseStatsList("all", &flags));
+  CU_ASSERT_EQUAL(flags, STATS_ALL);
+  CU_ASSERT_FALSE(ParseStatsList("min,median", &flags));
+  CU_ASSERT_FALSE(ParseStatsList("", &flags));
+}
+
+int main() {
+  CU_pSuite pSuite = NULL;
+
+  /* initialize the CUnit test registry */
+  if (CUE_SUCCESS != CU_initialize_registry()) return CU_get_error();
+
+  /* add a suite to the registry */
+  pSuite = CU_add_suite("Stats reduction", NULL, NULL);
+  if (NULL == pSuite) {
+    CU_cleanup_registry();
+    return CU_get_error();
+  }
+
+  /* add the tests to the suite */
+  if ((NULL == CU_add_test(pSuite, "small array", testSmallArray)) ||
+      (NULL == CU_add_test(pSuite, "histogram edge buckets", testHistogramEdges)) ||
+      (NULL == CU_add_test(pSuite, "merged parts match single pass",
+                           testMergeMatchesSinglePass)) ||
+      (NULL == CU_add_test(pSuite, "merge with empty part", testMergeEmpty)) ||
+      (NULL == CU_add_test(pSuite, "parse statistics list", testParseStatsList))) {
+    CU_cleanup_registry();
+    return CU_get_error();
+  }
+
+  /* Run all tests using the CUnit Basic interface */
+  CU_basic_set_mode(CU_BRM_VERBOSE);
+  CU_basic_run_tests();
+  /* make check должен падать на проваленных проверках */
+  unsigned int failures = CU_get_number_of_failures();
+  CU_cleanup_registry();
+  return failures > 0 ? 1 : CU_get_error();
+}
@@ -0,0 +1,20 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Постоянный пул потоков: потоки создаются один раз и переиспользуются
+// между запусками, поэтому стоимость pthread_create не входит в каждый замер.
+struct ThreadPool;
+
+// Задача получает общий аргумент и номер потока в пуле [0, threads)
+typedef void (*ThreadPoolTask)(void *arg, unsigned int worker);
+
+struct ThreadPool *ThreadPoolCreate(unsigned int threads);
+
+// Запускает task на каждом потоке пула и ждет, пока все они завершатся
+void ThreadPoolRun(struct ThreadPool *pool, ThreadPoolTask task, void *arg);
+
+unsigned int ThreadPoolSize(const struct ThreadPool *pool);
+
+void ThreadPoolDestroy(struct ThreadPool *pool);
+
+#endif
@@ -1,11 +1,31 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+// Размер кэш-линии: результаты разных потоков/процессов кладутся в отдельные
+// линии, чтобы запись одного не инвалидировала кэш другого
+#define CACHE_LINE_SIZE 64
+
 struct MinMax {
   int min;
   int max;
 };
 
+struct PaddedMinMax {
+  struct MinMax value;
+  char padding[CACHE_LINE_SIZE - sizeof(struct MinMax)];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+// Заполнение массива псевдослучайными числами в [0, RAND_MAX].
+// Генератор счетчиковый (SplitMix64): результат зависит только от seed и
+// индекса, поэтому одинаков при любом числе потоков.
 void GenerateArray(int *array, unsigned int array_size, unsigned int seed);
 
+// То же на threads_num потоках (0 - по числу доступных процессоров)
+void GenerateArrayParallel(int *array, unsigned int array_size, unsigned int seed,
+                           unsigned int threads_num);
+
+// Заполнение только диапазона [begin, end) - совпадает с частью GenerateArray
+void GenerateArrayRange(int *array, unsigned int begin, unsigned int end,
+                        unsigned int seed);
+
 #endif
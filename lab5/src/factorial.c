@@ -1,18 +1,47 @@
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include "bigint.h"
+
+#define CACHE_LINE_SIZE 64
 
 // Глобальные переменные
-unsigned long long result = 1;  // Результат вычисления факториала
 int k;                          // Число, факториал которого вычисляем
 int mod;                        // Модуль
 int num_threads;                // Количество потоков
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;  // Мьютекс для синхронизации
+int range_begin = 1;            // Перемножаемый потоками диапазон
+int range_end;
 
-// Структура для передачи данных в поток
+// Структура для передачи данных в поток. Каждый поток пишет свое частичное
+// произведение в собственную ячейку: блокировки не нужны, а выравнивание
+// по кэш-линии не дает соседним потокам делить одну линию
 typedef struct {
     int thread_id;
-} thread_data;
+    unsigned long long partial;  // Частичное произведение потока
+} __attribute__((aligned(CACHE_LINE_SIZE))) thread_data;
+
+// Проверка числа на простоту перебором делителей до корня
+bool is_prime(int n) {
+    if (n < 2) return false;
+    for (long long d = 2; d * d <= n; d++) {
+        if (n % d == 0) return false;
+    }
+    return true;
+}
+
+// base^exp mod m
+unsigned long long pow_mod(unsigned long long base, int exp, int m) {
+    unsigned long long res = 1 % m;
+    base %= m;
+    while (exp > 0) {
+        if (exp & 1) res = res * base % m;
+        base = base * base % m;
+        exp >>= 1;
+    }
+    return res;
+}
 
 // Функция, выполняемая каждым потоком
 void* compute_factorial(void* arg) {
@@ -20,8 +49,10 @@ void* compute_factorial(void* arg) {
     int thread_id = data->thread_id;
     
     // Вычисляем диапазон чисел для обработки этим потоком
-    int start = thread_id * (k / num_threads) + 1;
-    int end = (thread_id == num_threads - 1) ? k : (thread_id + 1) * (k / num_threads);
+    int length = range_end - range_begin + 1;
+    int start = range_begin + thread_id * (length / num_threads);
+    int end = (thread_id == num_threads - 1) ? range_end
+                                             : range_begin + (thread_id + 1) * (length / num_threads) - 1;
     
     unsigned long long partial_result = 1;
     
@@ -30,23 +61,22 @@ void* compute_factorial(void* arg) {
         partial_result = (partial_result * i) % mod;
     }
     
-    // Захватываем мьютекс для обновления общего результата
-    pthread_mutex_lock(&mutex);
-    result = (result * partial_result) % mod;
-    pthread_mutex_unlock(&mutex);
+    data->partial = partial_result;
     
     pthread_exit(NULL);
 }
 
 int main(int argc, char* argv[]) {
     // Парсинг аргументов командной строки
-    if (argc != 7) {
-        printf("Использование: %s -k <число> -pnum <потоки> -mod <модуль>\n", argv[0]);
-        return 1;
-    }
-    
+    bool exact = false;  // Точный факториал без модуля
+    k = -1;
     for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-k") == 0) {
+        if (strcmp(argv[i], "-exact") == 0) {
+            exact = true;
+        } else if (i + 1 >= argc) {
+            k = -1;  // У опции нет значения
+            break;
+        } else if (strcmp(argv[i], "-k") == 0) {
             k = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-pnum") == 0) {
             num_threads = atoi(argv[++i]);
@@ -55,23 +85,56 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    if (k < 0 || num_threads <= 0 || mod <= 0) {
-        printf("Неверные параметры: k, pnum и mod должны быть положительными числами\n");
+    if (k < 0 || num_threads <= 0 || (!exact && mod <= 0)) {
+        printf("Использование: %s -k <число> -pnum <потоки> (-mod <модуль> | -exact)\n", argv[0]);
         return 1;
     }
     
+    // Точный режим: дерево произведений [1, k] делится между потоками,
+    // а десятичная запись выводится по мере обхода разрядов
+    if (exact) {
+        struct BigInt factorial = BigIntParallelRangeProduct(1, k, num_threads);
+        printf("%d! = ", k);
+        BigIntPrint(stdout, &factorial);
+        printf("\n");
+        BigIntFree(&factorial);
+        return 0;
+    }
+    
     // Особые случаи
     if (k == 0 || k == 1) {
-        printf("%d! mod %d = 1\n", k, mod);
+        printf("%d! mod %d = %d\n", k, mod, 1 % mod);
         return 0;
     }
     
-    // Создаем потоки
-    pthread_t threads[num_threads];
-    thread_data thread_args[num_threads];
+    // Если среди множителей есть mod, произведение равно 0 без вычислений
+    if (k >= mod) {
+        printf("%d! mod %d = 0\n", k, mod);
+        return 0;
+    }
+
+    // Для простого mod по теореме Вильсона (mod-1)! = -1, поэтому при k,
+    // близком к mod, дешевле перемножить хвост (k+1)...(mod-1) и обратить:
+    // k! = -1 / ((k+1) * ... * (mod-1))
+    bool wilson = k > mod - 1 - k && is_prime(mod);
+    range_begin = wilson ? k + 1 : 1;
+    range_end = wilson ? mod - 1 : k;
+    if (num_threads > range_end - range_begin + 1) {
+        // Хвост может быть пустым (k = mod - 1), тогда хватит одного потока
+        num_threads = range_end >= range_begin ? range_end - range_begin + 1 : 1;
+    }
+
+    // Создаем потоки; массивы в куче, чтобы сотни потоков не упирались в стек
+    pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+    thread_data *thread_args = aligned_alloc(CACHE_LINE_SIZE, sizeof(thread_data) * num_threads);
+    if (threads == NULL || thread_args == NULL) {
+        printf("Недостаточно памяти для %d потоков\n", num_threads);
+        return 1;
+    }
     
     for (int i = 0; i < num_threads; i++) {
         thread_args[i].thread_id = i;
+        thread_args[i].partial = 1;
         int rc = pthread_create(&threads[i], NULL, compute_factorial, (void*)&thread_args[i]);
         if (rc) {
             printf("Ошибка при создании потока %d\n", i);
@@ -84,11 +147,25 @@ int main(int argc, char* argv[]) {
         pthread_join(threads[i], NULL);
     }
     
+    // Сворачиваем частичные произведения попарно деревом: на шаге step
+    // ячейка i поглощает ячейку i + step
+    for (int step = 1; step < num_threads; step *= 2) {
+        for (int i = 0; i + step < num_threads; i += 2 * step) {
+            thread_args[i].partial = thread_args[i].partial * thread_args[i + step].partial % mod;
+        }
+    }
+    unsigned long long result = thread_args[0].partial % mod;
+    
+    if (wilson) {
+        // Обратный по малой теореме Ферма: a^(mod-2)
+        result = (mod - 1) * pow_mod(result, mod - 2, mod) % mod;
+    }
+
     // Выводим результат
     printf("%d! mod %d = %llu\n", k, mod, result);
     
-    // Уничтожаем мьютекс
-    pthread_mutex_destroy(&mutex);
+    free(threads);
+    free(thread_args);
     
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <CUnit/Basic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bigint.h"
+
+#define FACTORIAL_100                                                                    \
+    "93326215443944152681699238856266700490715968264381621468592963895217599993229915" \
+    "608941463976156518286253697920827223758251185210916864000000000000000000000000"
+
+// Десятичная запись числа через BigIntPrint
+static char *ToString(const struct BigInt *x) {
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    if (out == NULL) return NULL;
+    BigIntPrint(out, x);
+    fclose(out);
+    return text;
+}
+
+static char *FactorialString(uint64_t n, unsigned int threads) {
+    struct BigInt x = threads > 1 ? BigIntParallelRangeProduct(1, n, threads)
+                                  : BigIntRangeProduct(1, n);
+    char *text = ToString(&x);
+    BigIntFree(&x);
+    return text;
+}
+
+// Для длинных ответов: число цифр, их сумма, начало и число нулей в конце
+static void CheckDigits(const char *text, size_t len, unsigned long digit_sum,
+                        const char *prefix, size_t zeros) {
+    CU_ASSERT_EQUAL(strlen(text), len);
+    unsigned long sum = 0;
+    for (const char *p = text; *p; p++) sum += *p - '0';
+    CU_ASSERT_EQUAL(sum, digit_sum);
+    CU_ASSERT_EQUAL(strncmp(text, prefix, strlen(prefix)), 0);
+    size_t trailing = 0;
+    for (size_t i = strlen(text); i > 0 && text[i - 1] == '0'; i--) trailing++;
+    CU_ASSERT_EQUAL(trailing, zeros);
+}
+
+void testPrint(void) {
+    uint64_t values[] = {0, 7, 1000000000, 1000000000000000001ull, UINT64_MAX};
+    const char *expected[] = {"0", "7", "1000000000", "1000000000000000001",
+                              "18446744073709551615"};
+    for (int i = 0; i < 5; i++) {
+        struct BigInt x = BigIntFromU64(values[i]);
+        char *text = ToString(&x);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(text);
+        CU_ASSERT_STRING_EQUAL(text, expected[i]);
+        free(text);
+        BigIntFree(&x);
+    }
+}
+
+void testMul(void) {
+    struct BigInt a = BigIntFromU64(UINT64_MAX);
+    struct BigInt zero = BigIntFromU64(0);
+
+    struct BigInt square = BigIntMul(&a, &a, 1);
+    char *text = ToString(&square);
+    CU_ASSERT_STRING_EQUAL(text, "340282366920938463426481119284349108225");
+    free(text);
+
+    // Произведение на ноль нормализуется до одного разряда
+    struct BigInt product = BigIntMul(&a, &zero, 1);
+    CU_ASSERT_EQUAL(product.len, 1);
+    text = ToString(&product);
+    CU_ASSERT_STRING_EQUAL(text, "0");
+    free(text);
+
+    BigIntFree(&square);
+    BigIntFree(&product);
+    BigIntFree(&a);
+    BigIntFree(&zero);
+}
+
+void testSmallFactorials(void) {
+    const char *expected[] = {"1", "1", "2", "6", "24", "120"};
+    for (uint64_t n = 0; n <= 5; n++) {
+        char *text = FactorialString(n, 1);
+        CU_ASSERT_STRING_EQUAL(text, expected[n]);
+        free(text);
+    }
+
+    char *text = FactorialString(20, 1);
+    CU_ASSERT_STRING_EQUAL(text, "2432902008176640000");
+    free(text);
+    text = FactorialString(100, 1);
+    CU_ASSERT_STRING_EQUAL(text, FACTORIAL_100);
+    free(text);
+}
+
+void testLargeFactorials(void) {
+    char *text = FactorialString(1000, 1);
+    CheckDigits(text, 2568, 10539, "402387260077", 249);
+    free(text);
+
+    // Здесь множители уже длиннее порога Карацубы
+    text = FactorialString(20000, 1);
+    CheckDigits(text, 77338, 325494, "181920632023", 4999);
+    free(text);
+}
+
+void testParallelMatchesSerial(void) {
+    char *serial = FactorialString(20000, 1);
+    unsigned int threads[] = {2, 3, 8};
+    for (int i = 0; i < 3; i++) {
+        char *parallel = FactorialString(20000, threads[i]);
+        CU_ASSERT_STRING_EQUAL(parallel, serial);
+        free(parallel);
+    }
+    free(serial);
+
+    // Отрезок не от единицы, длиннее листа дерева
+    struct BigInt x = BigIntParallelRangeProduct(999999000, 1000000000, 4);
+    char *text = ToString(&x);
+    CheckDigits(text, 9009, 39654, "999499625062", 258);
+    free(text);
+    BigIntFree(&x);
+
+    x = BigIntParallelRangeProduct(10, 9, 4);
+    text = ToString(&x);
+    CU_ASSERT_STRING_EQUAL(text, "1");
+    free(text);
+    BigIntFree(&x);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry()) return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("BigInt", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "decimal output", testPrint)) ||
+        (NULL == CU_add_test(pSuite, "multiplication", testMul)) ||
+        (NULL == CU_add_test(pSuite, "small factorials", testSmallFactorials)) ||
+        (NULL == CU_add_test(pSuite, "large factorials", testLargeFactorials)) ||
+        (NULL == CU_add_test(pSuite, "parallel product tree matches serial",
+                             testParallelMatchesSerial))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    /* make check должен падать на проваленных проверках */
+    unsigned int failures = CU_get_number_of_failures();
+    CU_cleanup_registry();
+    return failures > 0 ? 1 : CU_get_error();
+}
@@ -0,0 +1,344 @@
+#include "bigint.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Ниже этой длины школьное умножение быстрее Карацубы
+#define KARATSUBA_THRESHOLD 48
+// Умножения короче этого не стоят создания потока
+#define PARALLEL_THRESHOLD 2048
+// Листья дерева произведений перемножаются напрямую
+#define LEAF_RANGE 64
+
+static void *Allocate(size_t limbs) {
+    void *p = malloc(sizeof(uint32_t) * (limbs ? limbs : 1));
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory for %zu limbs\n", limbs);
+        exit(1);
+    }
+    return p;
+}
+
+static size_t Trim(const uint32_t *a, size_t n) {
+    while (n > 1 && a[n - 1] == 0) n--;
+    return n;
+}
+
+struct BigInt BigIntFromU64(uint64_t value) {
+    struct BigInt x;
+    x.limbs = Allocate(3);
+    x.len = 0;
+    do {
+        x.limbs[x.len++] = value % BIGINT_BASE;
+        value /= BIGINT_BASE;
+    } while (value > 0);
+    return x;
+}
+
+void BigIntFree(struct BigInt *x) {
+    free(x->limbs);
+    x->limbs = NULL;
+    x->len = 0;
+}
+
+// dst[0..dn) += src[0..sn), перенос распространяется в пределах dn
+static void AddInto(uint32_t *dst, size_t dn, const uint32_t *src, size_t sn) {
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < sn; i++) {
+        uint32_t cur = dst[i] + src[i] + carry;
+        carry = cur >= BIGINT_BASE;
+        dst[i] = carry ? cur - BIGINT_BASE : cur;
+    }
+    for (; carry && i < dn; i++) {
+        uint32_t cur = dst[i] + 1;
+        carry = cur >= BIGINT_BASE;
+        dst[i] = carry ? 0 : cur;
+    }
+}
+
+// dst[0..dn) -= src[0..sn), требуется dst >= src
+static void SubInto(uint32_t *dst, size_t dn, const uint32_t *src, size_t sn) {
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for (; i < sn; i++) {
+        int64_t cur = (int64_t)dst[i] - src[i] - borrow;
+        borrow = cur < 0;
+        dst[i] = (uint32_t)(borrow ? cur + BIGINT_BASE : cur);
+    }
+    for (; borrow && i < dn; i++) {
+        borrow = dst[i] == 0;
+        dst[i] = borrow ? BIGINT_BASE - 1 : dst[i] - 1;
+    }
+}
+
+// out[0..n+m) = a * b
+static void MulSchool(const uint32_t *a, size_t n, const uint32_t *b, size_t m, uint32_t *out) {
+    memset(out, 0, sizeof(uint32_t) * (n + m));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < m; j++) {
+            uint64_t cur = out[i + j] + (uint64_t)a[i] * b[j] + carry;
+            out[i + j] = cur % BIGINT_BASE;
+            carry = cur / BIGINT_BASE;
+        }
+        out[i + m] = (uint32_t)carry;
+    }
+}
+
+static void Mul(const uint32_t *a, size_t n, const uint32_t *b, size_t m, uint32_t *out,
+                unsigned int threads);
+
+struct MulTask {
+    const uint32_t *a;
+    size_t n;
+    const uint32_t *b;
+    size_t m;
+    uint32_t *out;
+    unsigned int threads;
+};
+
+static void *MulThread(void *arg) {
+    struct MulTask *task = (struct MulTask *)arg;
+    Mul(task->a, task->n, task->b, task->m, task->out, task->threads);
+    return NULL;
+}
+
+// Запускает умножение в новом потоке или, если поток не создался, сразу
+static bool MulAsync(pthread_t *thread, struct MulTask *task) {
+    if (pthread_create(thread, NULL, MulThread, task) == 0)
+        return true;
+    MulThread(task);
+    return false;
+}
+
+// out[0..n+m) = a * b для n >= m
+static void Mul(const uint32_t *a, size_t n, const uint32_t *b, size_t m, uint32_t *out,
+                unsigned int threads) {
+    if (n < m) {
+        Mul(b, m, a, n, out, threads);
+        return;
+    }
+    if (m < KARATSUBA_THRESHOLD) {
+        MulSchool(a, n, b, m, out);
+        return;
+    }
+
+    size_t half = n / 2;
+    if (m <= half) {
+        // Несбалансированные множители: a режется на куски длины m
+        memset(out, 0, sizeof(uint32_t) * (n + m));
+        uint32_t *part = Allocate(2 * m);
+        for (size_t i = 0; i < n; i += m) {
+            size_t len = n - i < m ? n - i : m;
+            Mul(a + i, len, b, m, part, 1);
+            AddInto(out + i, n + m - i, part, len + m);
+        }
+        free(part);
+        return;
+    }
+
+    // a = a1 * B^half + a0, b = b1 * B^half + b0
+    const uint32_t *a0 = a, *a1 = a + half, *b0 = b, *b1 = b + half;
+    size_t a1n = n - half, b1n = m - half;
+
+    // Суммы половин, на один разряд длиннее на случай переноса
+    size_t sbw = b1n > half ? b1n : half;
+    uint32_t *sa = Allocate(a1n + 1), *sb = Allocate(sbw + 1);
+    memcpy(sa, a1, sizeof(uint32_t) * a1n);
+    sa[a1n] = 0;
+    AddInto(sa, a1n + 1, a0, half);
+    memset(sb, 0, sizeof(uint32_t) * (sbw + 1));
+    memcpy(sb, b0, sizeof(uint32_t) * half);
+    AddInto(sb, sbw + 1, b1, b1n);
+    size_t san = Trim(sa, a1n + 1), sbn = Trim(sb, sbw + 1);
+    uint32_t *z1 = Allocate(san + sbn);
+
+    // z0 = a0 * b0 и z2 = a1 * b1 сразу на своих местах в out; на верхних
+    // уровнях все три произведения считаются параллельно
+    bool parallel = threads > 1 && m >= PARALLEL_THRESHOLD;
+    unsigned int sub = parallel ? (threads + 2) / 3 : 1;
+    struct MulTask t0 = {a0, half, b0, half, out, sub};
+    struct MulTask t2 = {a1, a1n, b1, b1n, out + 2 * half, sub};
+    pthread_t th0, th2;
+    bool async0 = false, async2 = false;
+    if (parallel) {
+        async0 = MulAsync(&th0, &t0);
+        async2 = MulAsync(&th2, &t2);
+    } else {
+        MulThread(&t0);
+        MulThread(&t2);
+    }
+    Mul(sa, san, sb, sbn, z1, sub);
+    if (async0) pthread_join(th0, NULL);
+    if (async2) pthread_join(th2, NULL);
+
+    // z1 = (a0 + a1)(b0 + b1) - z0 - z2 = a0 * b1 + a1 * b0; z0 и z2 не
+    // больше z1, поэтому после отбрасывания старших нулей они не длиннее его
+    size_t z1n = san + sbn;
+    SubInto(z1, z1n, out, Trim(out, 2 * half));
+    SubInto(z1, z1n, out + 2 * half, Trim(out + 2 * half, a1n + b1n));
+    z1n = Trim(z1, z1n);
+    AddInto(out + half, n + m - half, z1, z1n);
+
+    free(sa);
+    free(sb);
+    free(z1);
+}
+
+struct BigInt BigIntMul(const struct BigInt *a, const struct BigInt *b, unsigned int threads) {
+    struct BigInt r;
+    r.limbs = Allocate(a->len + b->len);
+    Mul(a->limbs, a->len, b->limbs, b->len, r.limbs, threads);
+    r.len = Trim(r.limbs, a->len + b->len);
+    return r;
+}
+
+// x *= factor для factor < 2^32
+static void MulSmall(struct BigInt *x, uint64_t factor) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < x->len; i++) {
+        uint64_t cur = (uint64_t)x->limbs[i] * factor + carry;
+        x->limbs[i] = cur % BIGINT_BASE;
+        carry = cur / BIGINT_BASE;
+    }
+    while (carry > 0) {
+        x->limbs[x->len++] = carry % BIGINT_BASE;
+        carry /= BIGINT_BASE;
+    }
+}
+
+// Лист дерева: множители копятся в машинном слове, пока помещаются в 32 бита
+static struct BigInt LeafProduct(uint64_t begin, uint64_t end) {
+    // Каждый множитель меньше 2^64 добавляет не больше 3 разрядов
+    struct BigInt x;
+    x.limbs = Allocate(3 * (end - begin + 1) + 1);
+    x.limbs[0] = 1;
+    x.len = 1;
+
+    uint64_t acc = 1;
+    for (uint64_t i = begin; i <= end; i++) {
+        if (i >= (1ull << 32)) {
+            // Большой множитель раскладывается на два разряда
+            MulSmall(&x, acc);
+            acc = 1;
+            struct BigInt big = BigIntFromU64(i);
+            struct BigInt r = BigIntMul(&x, &big, 1);
+            memcpy(x.limbs, r.limbs, sizeof(uint32_t) * r.len);
+            x.len = r.len;
+            BigIntFree(&r);
+            BigIntFree(&big);
+        } else if (acc * i >= (1ull << 32)) {
+            MulSmall(&x, acc);
+            acc = i;
+        } else {
+            acc *= i;
+        }
+        if (i == end) break;  // end может быть равен UINT64_MAX
+    }
+    MulSmall(&x, acc);
+    return x;
+}
+
+struct BigInt BigIntRangeProduct(uint64_t begin, uint64_t end) {
+    if (begin > end)
+        return BigIntFromU64(1);
+    if (end - begin < LEAF_RANGE)
+        return LeafProduct(begin, end);
+
+    // Половины дерева дают множители близкой длины, что и нужно Карацубе
+    uint64_t mid = begin + (end - begin) / 2;
+    struct BigInt left = BigIntRangeProduct(begin, mid);
+    struct BigInt right = BigIntRangeProduct(mid + 1, end);
+    struct BigInt r = BigIntMul(&left, &right, 1);
+    BigIntFree(&left);
+    BigIntFree(&right);
+    return r;
+}
+
+struct RangeTask {
+    uint64_t begin;
+    uint64_t end;
+    struct BigInt result;
+    // Для свертки: второй множитель и число потоков на умножение
+    struct BigInt *other;
+    unsigned int threads;
+};
+
+static void *RangeThread(void *arg) {
+    struct RangeTask *task = (struct RangeTask *)arg;
+    task->result = BigIntRangeProduct(task->begin, task->end);
+    return NULL;
+}
+
+static void *MergeThread(void *arg) {
+    struct RangeTask *task = (struct RangeTask *)arg;
+    struct BigInt r = BigIntMul(&task->result, task->other, task->threads);
+    BigIntFree(&task->result);
+    BigIntFree(task->other);
+    task->result = r;
+    return NULL;
+}
+
+struct BigInt BigIntParallelRangeProduct(uint64_t begin, uint64_t end, unsigned int threads) {
+    if (begin > end)
+        return BigIntFromU64(1);
+    uint64_t length = end - begin + 1;
+    if (threads < 2 || length < 2 * LEAF_RANGE)
+        return BigIntRangeProduct(begin, end);
+    if (threads > length / LEAF_RANGE) threads = length / LEAF_RANGE;
+
+    struct RangeTask *tasks = calloc(threads, sizeof(struct RangeTask));
+    pthread_t *handles = malloc(sizeof(pthread_t) * threads);
+    if (tasks == NULL || handles == NULL) {
+        fprintf(stderr, "Out of memory for %u threads\n", threads);
+        exit(1);
+    }
+
+    // Поддеревья по равным отрезкам: верхние отрезки дают числа длиннее,
+    // но свертка все равно упирается в последние большие умножения
+    for (unsigned int i = 0; i < threads; i++) {
+        tasks[i].begin = begin + length / threads * i;
+        tasks[i].end = (i == threads - 1) ? end : begin + length / threads * (i + 1) - 1;
+        if (pthread_create(&handles[i], NULL, RangeThread, &tasks[i]) != 0) {
+            RangeThread(&tasks[i]);
+            handles[i] = pthread_self();
+        }
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        if (!pthread_equal(handles[i], pthread_self())) pthread_join(handles[i], NULL);
+    }
+
+    // Попарная свертка: на шаге step задача i поглощает задачу i + step,
+    // освободившиеся потоки отдаются умножениям Карацубы
+    for (unsigned int step = 1; step < threads; step *= 2) {
+        unsigned int pairs = 0;
+        for (unsigned int i = 0; i + step < threads; i += 2 * step) pairs++;
+        unsigned int i = 0;
+        for (unsigned int p = 0; p < pairs; p++, i += 2 * step) {
+            tasks[i].other = &tasks[i + step].result;
+            tasks[i].threads = threads / pairs;
+            if (pthread_create(&handles[p], NULL, MergeThread, &tasks[i]) != 0) {
+                MergeThread(&tasks[i]);
+                handles[p] = pthread_self();
+            }
+        }
+        for (unsigned int p = 0; p < pairs; p++) {
+            if (!pthread_equal(handles[p], pthread_self())) pthread_join(handles[p], NULL);
+        }
+    }
+
+    struct BigInt result = tasks[0].result;
+    free(tasks);
+    free(handles);
+    return result;
+}
+
+void BigIntPrint(FILE *out, const struct BigInt *x) {
+    fprintf(out, "%u", x->limbs[x->len - 1]);
+    for (size_t i = x->len - 1; i-- > 0;) {
+        fprintf(out, "%09u", x->limbs[i]);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Основание разрядов: десятичный вывод сводится к печати разрядов по 9 цифр
+#define BIGINT_BASE 1000000000u
+
+// Неотрицательное целое произвольной длины, младшие разряды первыми.
+// У нормализованного числа старший разряд ненулевой; у нуля len == 1
+struct BigInt {
+    uint32_t *limbs;
+    size_t len;
+};
+
+struct BigInt BigIntFromU64(uint64_t value);
+void BigIntFree(struct BigInt *x);
+
+// a * b: Карацуба для длинных множителей, школьное умножение для коротких.
+// threads > 1 разрешает считать верхние уровни Карацубы в отдельных потоках
+struct BigInt BigIntMul(const struct BigInt *a, const struct BigInt *b, unsigned int threads);
+
+// Произведение чисел [begin, end] бинарным разбиением; 1 для пустого диапазона
+struct BigInt BigIntRangeProduct(uint64_t begin, uint64_t end);
+
+// То же дерево произведений, разделенное между threads потоками: каждый
+// поток строит поддерево своего отрезка, затем поддеревья попарно сворачиваются
+struct BigInt BigIntParallelRangeProduct(uint64_t begin, uint64_t end, unsigned int threads);
+
+// Десятичная запись пишется в поток по мере обхода разрядов
+void BigIntPrint(FILE *out, const struct BigInt *x);
+
+#endif // BIGINT_H
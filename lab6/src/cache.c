@@ -0,0 +1,176 @@
+#include "cache.h"
+
+#include <stdlib.h>
+
+struct Checkpoint {
+    uint64_t end;
+    uint64_t product;
+};
+
+struct CacheEntry {
+    uint64_t begin;
+    uint64_t mod;
+    struct Checkpoint points[CACHE_CHECKPOINTS];  // По возрастанию end
+    unsigned int points_num;
+    bool used;
+    bool referenced;  // Бит CLOCK: запись недавно использовалась
+    int next;         // Следующая запись в цепочке корзины
+};
+
+struct RangeCache {
+    struct CacheEntry *entries;
+    unsigned int capacity;
+    int *buckets;  // Первая запись цепочки или -1
+    unsigned int buckets_mask;
+    unsigned int hand;  // Стрелка CLOCK
+    struct CacheStats stats;
+};
+
+static unsigned int Bucket(const struct RangeCache *cache, uint64_t begin, uint64_t mod) {
+    uint64_t h = begin * 0x9e3779b97f4a7c15ULL ^ mod;
+    h ^= h >> 31;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 29;
+    return (unsigned int)h & cache->buckets_mask;
+}
+
+struct RangeCache *CacheCreate(unsigned int capacity) {
+    if (capacity == 0)
+        return NULL;
+
+    struct RangeCache *cache = calloc(1, sizeof(struct RangeCache));
+    if (cache == NULL)
+        return NULL;
+
+    unsigned int buckets = 1;
+    while (buckets < capacity) buckets *= 2;
+
+    cache->entries = calloc(capacity, sizeof(struct CacheEntry));
+    cache->buckets = malloc(sizeof(int) * buckets);
+    if (cache->entries == NULL || cache->buckets == NULL) {
+        CacheDestroy(cache);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < buckets; i++) {
+        cache->buckets[i] = -1;
+    }
+    cache->capacity = capacity;
+    cache->buckets_mask = buckets - 1;
+    return cache;
+}
+
+static struct CacheEntry *Find(struct RangeCache *cache, uint64_t begin, uint64_t mod) {
+    for (int i = cache->buckets[Bucket(cache, begin, mod)]; i >= 0; i = cache->entries[i].next) {
+        struct CacheEntry *entry = &cache->entries[i];
+        if (entry->begin == begin && entry->mod == mod)
+            return entry;
+    }
+    return NULL;
+}
+
+static void Unlink(struct RangeCache *cache, int index) {
+    struct CacheEntry *entry = &cache->entries[index];
+    int *link = &cache->buckets[Bucket(cache, entry->begin, entry->mod)];
+    while (*link != index) {
+        link = &cache->entries[*link].next;
+    }
+    *link = entry->next;
+}
+
+// Свободная запись или вытесненная по CLOCK: пропускаются записи с
+// битом обращения, бит при этом сбрасывается
+static struct CacheEntry *Allocate(struct RangeCache *cache, uint64_t begin, uint64_t mod) {
+    while (true) {
+        int index = cache->hand;
+        struct CacheEntry *entry = &cache->entries[index];
+        cache->hand = (cache->hand + 1) % cache->capacity;
+
+        if (entry->used && entry->referenced) {
+            entry->referenced = false;
+            continue;
+        }
+        if (entry->used) {
+            Unlink(cache, index);
+        } else {
+            cache->stats.entries++;
+        }
+
+        unsigned int bucket = Bucket(cache, begin, mod);
+        entry->begin = begin;
+        entry->mod = mod;
+        entry->points_num = 0;
+        entry->used = true;
+        entry->next = cache->buckets[bucket];
+        cache->buckets[bucket] = index;
+        return entry;
+    }
+}
+
+bool CacheLookup(struct RangeCache *cache, uint64_t begin, uint64_t end, uint64_t mod,
+                 uint64_t *covered_end, uint64_t *product) {
+    struct CacheEntry *entry = Find(cache, begin, mod);
+    const struct Checkpoint *best = NULL;
+    for (unsigned int i = 0; entry != NULL && i < entry->points_num; i++) {
+        if (entry->points[i].end <= end) best = &entry->points[i];
+    }
+    if (best == NULL) {
+        cache->stats.misses++;
+        return false;
+    }
+
+    entry->referenced = true;
+    if (best->end == end) {
+        cache->stats.hits++;
+    } else {
+        cache->stats.prefix_hits++;
+    }
+    *covered_end = best->end;
+    *product = best->product;
+    return true;
+}
+
+void CacheInsert(struct RangeCache *cache, uint64_t begin, uint64_t end, uint64_t mod,
+                 uint64_t product) {
+    struct CacheEntry *entry = Find(cache, begin, mod);
+    if (entry == NULL) entry = Allocate(cache, begin, mod);
+    entry->referenced = true;
+
+    struct Checkpoint *points = entry->points;
+    unsigned int pos = 0;
+    while (pos < entry->points_num && points[pos].end < end) pos++;
+    if (pos < entry->points_num && points[pos].end == end)
+        return;
+
+    if (entry->points_num == CACHE_CHECKPOINTS) {
+        // Места нет: выбрасывается самая короткая точка, она полезна реже
+        if (pos == 0)
+            return;
+        for (unsigned int i = 1; i < pos; i++) {
+            points[i - 1] = points[i];
+        }
+        pos--;
+    } else {
+        for (unsigned int i = entry->points_num; i > pos; i--) {
+            points[i] = points[i - 1];
+        }
+        entry->points_num++;
+    }
+    points[pos].end = end;
+    points[pos].product = product;
+}
+
+void CacheGetStats(const struct RangeCache *cache, struct CacheStats *stats) {
+    if (cache == NULL) {
+        stats->hits = stats->prefix_hits = stats->misses = stats->entries = 0;
+        return;
+    }
+    *stats = cache->stats;
+}
+
+void CacheDestroy(struct RangeCache *cache) {
+    if (cache == NULL)
+        return;
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+}
@@ -0,0 +1,39 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Диапазоны короче этого не кэшируются: пересчитать их дешевле
+#define CACHE_MIN_RANGE 1024
+// Контрольных точек на одну пару (begin, mod)
+#define CACHE_CHECKPOINTS 8
+
+struct CacheStats {
+    uint64_t hits;         // Диапазон найден целиком
+    uint64_t prefix_hits;  // Найдено начало диапазона, досчитывается хвост
+    uint64_t misses;
+    uint64_t entries;      // Занятых записей
+};
+
+// Кэш произведений диапазонов с вытеснением CLOCK. Запись хранит для пары
+// (begin, mod) несколько контрольных точек (end, произведение [begin, end]),
+// поэтому запрос [begin, n] может продолжить счет с ближайшей точки m < n.
+// Кэш не потокобезопасен
+struct RangeCache;
+
+struct RangeCache *CacheCreate(unsigned int capacity);
+
+// Ищет ближайшую точку не дальше end. При успехе *covered_end - конец
+// найденного диапазона, *product - его произведение
+bool CacheLookup(struct RangeCache *cache, uint64_t begin, uint64_t end, uint64_t mod,
+                 uint64_t *covered_end, uint64_t *product);
+
+void CacheInsert(struct RangeCache *cache, uint64_t begin, uint64_t end, uint64_t mod,
+                 uint64_t product);
+
+void CacheGetStats(const struct RangeCache *cache, struct CacheStats *stats);
+
+void CacheDestroy(struct RangeCache *cache);
+
+#endif // CACHE_H
@@ -7,15 +7,25 @@
 #include <getopt.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <pthread.h>
+#include <time.h>
+#include "bigint.h"
+#include "protocol.h"
 #include "utils.h"
 
+// Ограничения на --batch и --pipeline
+#define MAX_BATCH 64
+#define MAX_PIPELINE 64
+
 // Структура для хранения информации о сервере
 struct Server {
     char ip[255];  // IP-адрес сервера
     int port;      // Порт сервера
+    double weight; // Относительная производительность (третий столбец, по умолчанию 1)
+    bool has_weight; // Вес задан в файле; без весов во всем файле берется HELLO
 };
 
 // Функция для преобразования строки в uint64_t с проверкой ошибок
@@ -51,8 +61,17 @@ void ReadServersFromFile(const char *filename, struct Server **servers, int *num
     while (fgets(line, sizeof(line), file)) {
         // Динамическое выделение памяти для серверов
         *servers = realloc(*servers, sizeof(struct Server) * (count + 1));
-        // Парсинг IP и порта из строки
-        sscanf(line, "%s %d", (*servers)[count].ip, &(*servers)[count].port);
+        // Парсинг IP, порта и необязательного веса из строки
+        struct Server *server = &(*servers)[count];
+        server->weight = 1.0;
+        int fields = sscanf(line, "%254s %d %lf", server->ip, &server->port, &server->weight);
+        if (fields < 2)
+            continue;  // Пустая строка
+        server->has_weight = fields == 3;
+        if (server->weight <= 0) {
+            fprintf(stderr, "Bad weight for %s:%d\n", server->ip, server->port);
+            exit(EXIT_FAILURE);
+        }
         count++;
     }
 
@@ -60,10 +79,353 @@ void ReadServersFromFile(const char *filename, struct Server **servers, int *num
     fclose(file);  // Закрытие файла
 }
 
+// Очередь диапазонов отрезка [first, last], поделенного на count равных
+// частей. В динамическом режиме очередь общая: кто из серверов освободился,
+// тот и берет следующие диапазоны. В статическом у каждого сервера своя
+struct RangeQueue {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;  // Диапазон вернулся в очередь или посчитан
+    uint64_t first;
+    uint64_t last;
+    uint64_t count;   // Всего диапазонов
+    uint64_t next;    // Следующий еще не выданный диапазон
+    uint64_t *retry;  // Диапазоны, не посчитанные отказавшими серверами
+    uint64_t retry_len;
+    uint64_t outstanding;  // Выданы и еще без ответа
+};
+
+// Задание для потока, работающего с одним сервером
+struct ServerTask {
+    const struct Server *server;
+    int fd;             // Постоянное соединение
+    uint32_t threads;   // Из HELLO
+    uint64_t throughput;
+    uint64_t mod;
+    struct RangeQueue *queue;
+    unsigned int batch;     // Диапазонов в одном кадре
+    unsigned int pipeline;  // Кадров без ответа
+    struct BigInt exact;  // Точное произведение диапазона (--exact)
+    uint64_t ranges;    // Сколько диапазонов посчитал сервер
+    double elapsed_ms;  // Время от первого запроса до последнего ответа
+    bool ok;
+};
+
+// Запрос, на который еще не пришел ответ
+struct Inflight {
+    bool used;
+    uint64_t id;
+    uint32_t count;
+    uint64_t index[MAX_BATCH];
+};
+
+// Общий результат: каждый поток домножает свои ответы сразу по получении
+static uint64_t total_result = 1;
+static pthread_mutex_t result_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static double NowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Подключение к серверу; getaddrinfo, в отличие от gethostbyname, потокобезопасна
+static int ConnectToServer(const struct Server *server) {
+    char port[16];
+    snprintf(port, sizeof(port), "%d", server->port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;  // IPv4
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *addrs;
+    int err = getaddrinfo(server->ip, port, &hints, &addrs);
+    if (err != 0) {
+        fprintf(stderr, "getaddrinfo failed with %s: %s\n", server->ip, gai_strerror(err));
+        return -1;
+    }
+
+    int sck = -1;
+    for (struct addrinfo *a = addrs; a != NULL && sck < 0; a = a->ai_next) {
+        sck = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (sck < 0) continue;
+        if (connect(sck, a->ai_addr, a->ai_addrlen) < 0) {
+            close(sck);
+            sck = -1;
+        }
+    }
+    freeaddrinfo(addrs);
+    if (sck < 0) {
+        fprintf(stderr, "Connection to %s:%d failed\n", server->ip, server->port);
+        return -1;
+    }
+
+    // Запросы конвейера маленькие и не должны ждать друг друга
+    int opt = 1;
+    setsockopt(sck, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    return sck;
+}
+
+static void PrintServerError(const struct Server *server, const uint8_t *payload,
+                             uint32_t length) {
+    if (length < 4) {
+        fprintf(stderr, "Server %s:%d: malformed error\n", server->ip, server->port);
+        return;
+    }
+    fprintf(stderr, "Server %s:%d: error %u: %.*s\n", server->ip, server->port,
+            GetU32(payload), (int)(length - 4), (const char *)payload + 4);
+}
+
+// Подключение и обмен HELLO: сервер сообщает число потоков и производительность
+static void *Handshake(void *arg) {
+    struct ServerTask *task = (struct ServerTask *)arg;
+    task->fd = ConnectToServer(task->server);
+    if (task->fd < 0) return NULL;
+
+    uint8_t *payload = malloc(PROTO_MAX_PAYLOAD);
+    struct FrameHeader header;
+    if (payload == NULL || !SendFrame(task->fd, MSG_HELLO, 0, NULL, 0) ||
+        !RecvFrame(task->fd, &header, payload) || header.type != MSG_HELLO ||
+        header.length != 12) {
+        fprintf(stderr, "Handshake with %s:%d failed\n", task->server->ip, task->server->port);
+        close(task->fd);
+        task->fd = -1;
+    } else {
+        task->threads = GetU32(payload);
+        task->throughput = GetU64(payload + 4);
+    }
+    free(payload);
+    return NULL;
+}
+
+// Границы i-го из count равных диапазонов очереди
+static void RangeBounds(const struct RangeQueue *queue, uint64_t i, uint64_t *begin,
+                        uint64_t *end) {
+    unsigned __int128 length = (unsigned __int128)queue->last - queue->first + 1;
+    *begin = queue->first + (uint64_t)(length * i / queue->count);
+    *end = queue->first + (uint64_t)(length * (i + 1) / queue->count) - 1;
+}
+
+// С wait поток, которому больше нечего ждать, не уходит, пока другие
+// серверы держат диапазоны: отказавший сервер вернет их в очередь, и
+// посчитать их будет некому, если все остальные потоки уже завершились.
+// Поток с запросами в полете ждать не должен - иначе их ответы никто не примет
+static bool TakeRange(struct RangeQueue *queue, uint64_t *index, bool wait) {
+    bool found = true;
+    pthread_mutex_lock(&queue->mutex);
+    while (true) {
+        if (queue->retry_len > 0) {
+            *index = queue->retry[--queue->retry_len];
+        } else if (queue->next < queue->count) {
+            *index = queue->next++;
+        } else if (wait && queue->outstanding > 0) {
+            pthread_cond_wait(&queue->changed, &queue->mutex);
+            continue;
+        } else {
+            found = false;
+            break;
+        }
+        queue->outstanding++;
+        break;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return found;
+}
+
+// Диапазоны посчитаны: ждущие потоки проверяют, осталась ли работа
+static void FinishRanges(struct RangeQueue *queue, uint64_t count) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->outstanding -= count;
+    if (queue->outstanding == 0) pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static void ReturnRange(struct RangeQueue *queue, uint64_t index) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->retry[queue->retry_len++] = index;
+    queue->outstanding--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static void InitRangeQueue(struct RangeQueue *queue, uint64_t first, uint64_t last,
+                           uint64_t count) {
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->first = first;
+    queue->last = last;
+    queue->count = count;
+    queue->next = 0;
+    queue->retry = malloc(sizeof(uint64_t) * count);
+    queue->retry_len = 0;
+    queue->outstanding = 0;
+}
+
+static void DestroyRangeQueue(struct RangeQueue *queue) {
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->changed);
+    free(queue->retry);
+}
+
+// Отправляет кадр из batch диапазонов очереди; false, если очередь пуста.
+// wait - у потока нет запросов в полете, и он может ждать первый диапазон
+static bool SendBatch(struct ServerTask *task, struct Inflight *slot, uint64_t id,
+                      uint8_t *payload, bool wait, bool *failed) {
+    slot->count = 0;
+    while (slot->count < task->batch &&
+           TakeRange(task->queue, &slot->index[slot->count], wait && slot->count == 0)) {
+        slot->count++;
+    }
+    if (slot->count == 0) return false;
+
+    PutU64(payload, task->mod);
+    PutU32(payload + 8, slot->count);
+    for (uint32_t i = 0; i < slot->count; i++) {
+        uint64_t begin, end;
+        RangeBounds(task->queue, slot->index[i], &begin, &end);
+        PutU64(payload + 12 + 16 * i, begin);
+        PutU64(payload + 20 + 16 * i, end);
+    }
+    slot->id = id;
+    slot->used = true;
+    if (!SendFrame(task->fd, MSG_RANGE_REQUEST, id, payload, RangeRequestSize(slot->count))) {
+        fprintf(stderr, "Send to %s:%d failed\n", task->server->ip, task->server->port);
+        *failed = true;
+    }
+    return true;
+}
+
+// Конвейер: до pipeline кадров ждут ответа одновременно, ответы приходят
+// в любом порядке и сопоставляются с запросами по id
+static void *QueryServer(void *arg) {
+    struct ServerTask *task = (struct ServerTask *)arg;
+    double start = NowMs();
+    uint8_t *payload = malloc(PROTO_MAX_PAYLOAD);
+    struct Inflight *slots = calloc(task->pipeline, sizeof(struct Inflight));
+    unsigned int active = 0;
+    uint64_t next_id = 1;
+    bool failed = false;
+
+    while (!failed) {
+        for (unsigned int i = 0; i < task->pipeline && !failed; i++) {
+            if (slots[i].used) continue;
+            if (!SendBatch(task, &slots[i], next_id, payload, active == 0, &failed)) break;
+            next_id++;
+            active++;
+        }
+        if (active == 0 || failed) break;
+
+        struct FrameHeader header;
+        if (!RecvFrame(task->fd, &header, payload)) {
+            fprintf(stderr, "Receive from %s:%d failed\n", task->server->ip, task->server->port);
+            failed = true;
+            break;
+        }
+        if (header.type == MSG_ERROR) {
+            PrintServerError(task->server, payload, header.length);
+            failed = true;
+            break;
+        }
+
+        struct Inflight *slot = NULL;
+        for (unsigned int i = 0; i < task->pipeline; i++) {
+            if (slots[i].used && slots[i].id == header.request_id) slot = &slots[i];
+        }
+        if (header.type != MSG_RANGE_RESPONSE || slot == NULL || header.length < 4 ||
+            GetU32(payload) != slot->count || header.length != 4 + 8 * slot->count) {
+            fprintf(stderr, "Unexpected reply from %s:%d\n", task->server->ip, task->server->port);
+            failed = true;
+            break;
+        }
+
+        uint64_t product = 1 % task->mod;
+        for (uint32_t i = 0; i < slot->count; i++) {
+            product = MultModulo(product, GetU64(payload + 4 + 8 * i), task->mod);
+        }
+        pthread_mutex_lock(&result_mutex);
+        total_result = MultModulo(total_result, product, task->mod);
+        pthread_mutex_unlock(&result_mutex);
+
+        FinishRanges(task->queue, slot->count);
+        task->ranges += slot->count;
+        slot->used = false;
+        active--;
+    }
+
+    // Диапазоны без ответа возвращаются в очередь другим серверам
+    for (unsigned int i = 0; i < task->pipeline; i++) {
+        for (uint32_t j = 0; slots[i].used && j < slots[i].count; j++) {
+            ReturnRange(task->queue, slots[i].index[j]);
+        }
+    }
+    task->ok = !failed;
+    task->elapsed_ms = NowMs() - start;
+    free(slots);
+    free(payload);
+    return NULL;
+}
+
+// Точное произведение своего отрезка одним запросом
+static void *QueryExact(void *arg) {
+    struct ServerTask *task = (struct ServerTask *)arg;
+    double start = NowMs();
+    uint64_t index, begin, end;
+    if (!TakeRange(task->queue, &index, false)) return NULL;
+    RangeBounds(task->queue, index, &begin, &end);
+
+    uint8_t request[16];
+    PutU64(request, begin);
+    PutU64(request + 8, end);
+    uint8_t *payload = malloc(PROTO_MAX_PAYLOAD);
+    struct FrameHeader header;
+    if (payload == NULL || !SendFrame(task->fd, MSG_EXACT_REQUEST, 1, request, sizeof(request)) ||
+        !RecvFrame(task->fd, &header, payload)) {
+        fprintf(stderr, "Exact request to %s:%d failed\n", task->server->ip, task->server->port);
+    } else if (header.type == MSG_ERROR) {
+        PrintServerError(task->server, payload, header.length);
+    } else if (header.type != MSG_EXACT_RESPONSE ||
+               !DecodeBigInt(payload, header.length, &task->exact)) {
+        fprintf(stderr, "Unexpected reply from %s:%d\n", task->server->ip, task->server->port);
+    } else {
+        task->ok = true;
+        task->ranges = 1;
+    }
+    if (task->ok) {
+        FinishRanges(task->queue, 1);
+    } else {
+        ReturnRange(task->queue, index);
+    }
+    task->elapsed_ms = NowMs() - start;
+    free(payload);
+    return NULL;
+}
+
+// Запрос STATS по уже открытому соединению
+static void PrintServerStats(const struct ServerTask *task) {
+    uint8_t *payload = malloc(PROTO_MAX_PAYLOAD);
+    struct FrameHeader header;
+    if (payload == NULL || !SendFrame(task->fd, MSG_STATS, 0, NULL, 0) ||
+        !RecvFrame(task->fd, &header, payload) || header.type != MSG_STATS ||
+        header.length != 32) {
+        fprintf(stderr, "Stats from %s:%d failed\n", task->server->ip, task->server->port);
+    } else {
+        printf("Server %s:%d cache: %llu hits, %llu prefix hits, %llu misses, %llu entries\n",
+               task->server->ip, task->server->port, (unsigned long long)GetU64(payload),
+               (unsigned long long)GetU64(payload + 8), (unsigned long long)GetU64(payload + 16),
+               (unsigned long long)GetU64(payload + 24));
+    }
+    free(payload);
+}
+
 int main(int argc, char **argv) {
     uint64_t k = -1;          // Число для вычисления факториала
     uint64_t mod = -1;        // Модуль
     char servers_file[255] = {'\0'};  // Путь к файлу с серверами
+    uint64_t dynamic = 0;     // Число мелких диапазонов (0 - статическое разбиение)
+    uint64_t batch = 1;
+    uint64_t pipeline = 4;
+    bool stats = false;
+    bool exact = false;       // Точный факториал вместо остатка
 
     // Парсинг аргументов командной строки
     while (true) {
@@ -73,6 +435,11 @@ int main(int argc, char **argv) {
             {"k", required_argument, 0, 0},        // Опция для числа k
             {"mod", required_argument, 0, 0},      // Опция для модуля
             {"servers", required_argument, 0, 0},   // Опция для файла серверов
+            {"dynamic", required_argument, 0, 0},   // Динамическая балансировка
+            {"batch", required_argument, 0, 0},     // Диапазонов в кадре
+            {"pipeline", required_argument, 0, 0},  // Кадров без ответа
+            {"stats", no_argument, 0, 0},           // Статистика кэша серверов
+            {"exact", no_argument, 0, 0},           // Точный факториал
             {0, 0, 0, 0}
         };
 
@@ -94,6 +461,21 @@ int main(int argc, char **argv) {
             case 2:  // Обработка --servers
                 memcpy(servers_file, optarg, strlen(optarg));
                 break;
+            case 3:  // Обработка --dynamic
+                ConvertStringToUI64(optarg, &dynamic);
+                break;
+            case 4:  // Обработка --batch
+                ConvertStringToUI64(optarg, &batch);
+                break;
+            case 5:  // Обработка --pipeline
+                ConvertStringToUI64(optarg, &pipeline);
+                break;
+            case 6:  // Обработка --stats
+                stats = true;
+                break;
+            case 7:  // Обработка --exact
+                exact = true;
+                break;
             default:
                 printf("Index %d is out of options\n", option_index);
             }
@@ -108,8 +490,14 @@ int main(int argc, char **argv) {
     }
 
     // Проверка обязательных аргументов
-    if (k == -1 || mod == -1 || !strlen(servers_file)) {
-        fprintf(stderr, "Using: %s --k 1000 --mod 5 --servers /path/to/file\n", argv[0]);
+    // В точном режиме модуль не нужен, а диапазон делится только статически
+    if (k == -1 || (!exact && (mod == -1 || mod == 0)) || (exact && dynamic > 0) ||
+        !strlen(servers_file) || batch == 0 || batch > MAX_BATCH || pipeline == 0 ||
+        pipeline > MAX_PIPELINE) {
+        fprintf(stderr,
+                "Using: %s --k 1000 (--mod 5 | --exact) --servers /path/to/file [--dynamic N] "
+                "[--batch 1..%d] [--pipeline 1..%d] [--stats]\n",
+                argv[0], MAX_BATCH, MAX_PIPELINE);
         return 1;
     }
 
@@ -117,70 +505,168 @@ int main(int argc, char **argv) {
     struct Server *servers = NULL;
     int num_servers = 0;
     ReadServersFromFile(servers_file, &servers, &num_servers);
+    if (num_servers == 0) {
+        fprintf(stderr, "No servers in %s\n", servers_file);
+        return 1;
+    }
 
-    uint64_t total_result = 1;  // Итоговый результат
     pthread_t *threads = malloc(sizeof(pthread_t) * num_servers);  // Потоки
+    struct ServerTask *tasks = calloc(num_servers, sizeof(struct ServerTask));
 
-    // Обработка каждого сервера
+    // Подключение ко всем серверам и HELLO параллельно
     for (int i = 0; i < num_servers; i++) {
-        // Настройка адреса сервера
-        struct sockaddr_in server;
-        server.sin_family = AF_INET;  // IPv4
-        server.sin_port = htons(servers[i].port);  // Порт
-        struct hostent *hostname = gethostbyname(servers[i].ip);  // Получение IP по имени
-        if (hostname == NULL) {
-            fprintf(stderr, "gethostbyname failed with %s\n", servers[i].ip);
+        tasks[i].server = &servers[i];
+        if (pthread_create(&threads[i], NULL, Handshake, &tasks[i]) != 0) {
+            perror("pthread_create");
             exit(1);
         }
-        server.sin_addr.s_addr = *((unsigned long *)hostname->h_addrtype);
+    }
+    for (int i = 0; i < num_servers; i++) {
+        pthread_join(threads[i], NULL);
+    }
 
-        // Создание сокета
-        int sck = socket(AF_INET, SOCK_STREAM, 0);
-        if (sck < 0) {
-            fprintf(stderr, "Socket creation failed!\n");
-            exit(1);
+    // Веса из файла и производительность из HELLO в разных единицах, и
+    // смешивать их нельзя. Производительность заменяет веса, только если ни
+    // в одной строке вес не задан и ее сообщили все серверы; иначе делим по
+    // весам файла (по умолчанию 1). Недоступные серверы в разбиении не участвуют
+    bool use_throughput = true;
+    for (int i = 0; i < num_servers; i++) {
+        if (tasks[i].fd < 0) continue;
+        if (servers[i].has_weight || tasks[i].throughput == 0) use_throughput = false;
+    }
+    double total_weight = 0;
+    for (int i = 0; i < num_servers; i++) {
+        if (tasks[i].fd < 0) continue;
+        if (use_throughput) servers[i].weight = tasks[i].throughput;
+        total_weight += servers[i].weight;
+    }
+    if (total_weight == 0) {
+        fprintf(stderr, "No servers available\n");
+        return 1;
+    }
+
+    // Серверам раздается отрезок [first, last]. Для простого mod и k,
+    // близкого к mod, по теореме Вильсона (mod-1)! = -1, и вместо [1, k]
+    // дешевле посчитать хвост [k+1, mod-1]: k! = -1 / ((k+1) * ... * (mod-1))
+    uint64_t first = 1, last = k;
+    bool wilson = !exact && k < mod && k > mod - 1 - k && IsPrime(mod);
+    if (wilson) {
+        first = k + 1;
+        last = mod - 1;
+    }
+    uint64_t length = last >= first ? last - first + 1 : 0;
+
+    struct RangeQueue shared;
+    struct RangeQueue *queues = calloc(num_servers, sizeof(struct RangeQueue));
+    if (dynamic > 0) {
+        if (dynamic > length) dynamic = length ? length : 1;
+        InitRangeQueue(&shared, first, last, dynamic);
+    }
+
+    // Запросы ко всем серверам идут одновременно, и общее время
+    // определяется самым медленным сервером, а не суммой
+    double weight_before = 0;
+    int last_alive = -1;
+    for (int i = 0; i < num_servers; i++) {
+        if (tasks[i].fd >= 0) last_alive = i;
+    }
+    for (int i = 0; i < num_servers; i++) {
+        if (tasks[i].fd < 0) continue;
+        tasks[i].mod = mod;
+        tasks[i].batch = batch;
+        tasks[i].pipeline = pipeline;
+
+        if (dynamic > 0) {
+            tasks[i].queue = &shared;
+        } else {
+            // Статическое разбиение пропорционально весам серверов
+            long double from = weight_before / total_weight;
+            weight_before += servers[i].weight;
+            long double to = weight_before / total_weight;
+            uint64_t begin = first + (uint64_t)(length * from);
+            uint64_t end = (i == last_alive) ? last : first + (uint64_t)(length * to) - 1;
+            InitRangeQueue(&queues[i], begin, end, 1);
+            tasks[i].queue = &queues[i];
         }
 
-        // Подключение к серверу
-        if (connect(sck, (struct sockaddr *)&server, sizeof(server)) < 0) {
-            fprintf(stderr, "Connection failed\n");
+        if (pthread_create(&threads[i], NULL, exact ? QueryExact : QueryServer, &tasks[i]) != 0) {
+            perror("pthread_create");
             exit(1);
         }
+    }
 
-        // Распределение задач между серверами
-        uint64_t chunk_size = k / num_servers;
-        uint64_t begin = i * chunk_size + 1;
-        uint64_t end = (i == num_servers - 1) ? k : (begin + chunk_size - 1);
+    bool ok = true;
+    for (int i = 0; i < num_servers; i++) {
+        if (tasks[i].fd < 0) continue;
+        pthread_join(threads[i], NULL);
+        if (stats && tasks[i].ok) PrintServerStats(&tasks[i]);
+        close(tasks[i].fd);
+    }
 
-        // Формирование задачи для сервера
-        char task[sizeof(uint64_t) * 3];
-        memcpy(task, &begin, sizeof(uint64_t));  // Начало диапазона
-        memcpy(task + sizeof(uint64_t), &end, sizeof(uint64_t));  // Конец диапазона
-        memcpy(task + 2 * sizeof(uint64_t), &mod, sizeof(uint64_t));  // Модуль
+    // Все ли диапазоны посчитаны
+    for (int i = 0; i < num_servers; i++) {
+        struct RangeQueue *queue = dynamic > 0 ? &shared : &queues[i];
+        if (dynamic == 0 && tasks[i].fd < 0) continue;
+        ok = ok && queue->next == queue->count && queue->retry_len == 0;
+        if (dynamic == 0) DestroyRangeQueue(queue);
+    }
+    if (dynamic > 0) DestroyRangeQueue(&shared);
 
-        // Отправка задачи серверу
-        if (send(sck, task, sizeof(task), 0) < 0) {
-            fprintf(stderr, "Send failed\n");
-            exit(1);
+    // Задержка и доля работы каждого сервера
+    for (int i = 0; i < num_servers; i++) {
+        if (tasks[i].fd < 0) {
+            printf("Server %s:%d: unavailable\n", servers[i].ip, servers[i].port);
+            continue;
         }
+        printf("Server %s:%d (%u threads, weight %g): %s %llu ranges %.3f ms\n",
+               servers[i].ip, servers[i].port, tasks[i].threads, servers[i].weight,
+               tasks[i].ok ? "ok" : "failed", (unsigned long long)tasks[i].ranges,
+               tasks[i].elapsed_ms);
+    }
+    free(queues);
+    if (!ok) {
+        fprintf(stderr, "Some servers did not respond\n");
+        free(servers);
+        free(threads);
+        free(tasks);
+        return 1;
+    }
 
-        // Получение результата от сервера
-        uint64_t response;
-        if (recv(sck, &response, sizeof(response), 0) < 0) {
-            fprintf(stderr, "Receive failed\n");
-            exit(1);
+    // Точные произведения отрезков сворачиваются попарно деревом, чтобы
+    // множители Карацубы были близкой длины; вывод идет по мере печати разрядов
+    if (exact) {
+        int n = 0;
+        for (int i = 0; i < num_servers; i++) {
+            if (tasks[i].fd >= 0) tasks[n++].exact = tasks[i].exact;
         }
-
-        // Обновление общего результата
-        total_result = MultModulo(total_result, response, mod);
-        close(sck);  // Закрытие сокета
+        for (int step = 1; step < n; step *= 2) {
+            for (int i = 0; i + step < n; i += 2 * step) {
+                struct BigInt product = BigIntMul(&tasks[i].exact, &tasks[i + step].exact, 1);
+                BigIntFree(&tasks[i].exact);
+                BigIntFree(&tasks[i + step].exact);
+                tasks[i].exact = product;
+            }
+        }
+        printf("Final result: ");
+        BigIntPrint(stdout, &tasks[0].exact);
+        printf("\n");
+        BigIntFree(&tasks[0].exact);
+        free(servers);
+        free(threads);
+        free(tasks);
+        return 0;
     }
 
     // Вывод итогового результата
-    printf("Final result: %llu\n", total_result);
+    if (wilson) {
+        // Обратный по малой теореме Ферма: a^(mod-2)
+        total_result = MultModulo(mod - 1, PowModulo(total_result, mod - 2, mod), mod);
+    }
+    printf("Final result: %llu\n", (unsigned long long)total_result);
     
     // Освобождение памяти
     free(servers);
     free(threads);
+    free(tasks);
     return 0;
 }
\ No newline at end of file
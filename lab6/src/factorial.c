@@ -0,0 +1,82 @@
+#include "factorial.h"
+
+#include "utils.h"
+
+// Диапазоны короче этого считаются без проверки модуля на простоту
+#define WILSON_MIN_RANGE 4096
+
+// Прямое перемножение всех чисел диапазона
+static uint64_t DirectProduct(uint64_t begin, uint64_t end, uint64_t mod) {
+    // Для нечетного модуля произведение считается в форме Монтгомери:
+    // в цикле нет делений, только умножения
+    struct Montgomery m;
+    if (begin <= end && MontgomeryInit(&m, mod)) {
+        return MontgomeryRangeProduct(&m, begin, end);
+    }
+
+    uint64_t ans = 1 % mod;
+    // Умножение всех чисел в диапазоне [begin, end] по модулю mod
+    for (uint64_t i = begin; i <= end; i++) {
+        ans = MultModulo(ans, i, mod);  // Функция из utils.h
+        if (i == UINT64_MAX) break;
+    }
+    return ans;
+}
+
+// Сколько умножений нужно для n! mod p: напрямую или через теорему
+// Вильсона (p-1)! = -1, откуда n! = -1 / ((n+1) * ... * (p-1))
+static uint64_t PrefixCost(uint64_t n, uint64_t p) {
+    return n <= p - 1 - n ? n : p - 1 - n;
+}
+
+// n! mod p для простого p и n < p
+static uint64_t PrimePrefix(uint64_t n, uint64_t p) {
+    if (n <= p - 1 - n) {
+        return DirectProduct(1, n, p);
+    }
+    uint64_t suffix = DirectProduct(n + 1, p - 1, p);
+    // Обратный по малой теореме Ферма: a^(p-2)
+    return MultModulo(p - 1, PowModulo(suffix, p - 2, p), p);
+}
+
+bool FactorialReduce(struct FactorialArgs *args, uint64_t *result) {
+    uint64_t mod = args->mod;
+    if (args->begin > args->end) {
+        *result = 1 % mod;
+        return true;
+    }
+
+    // Если в диапазоне есть кратное mod (в том числе 0), произведение равно 0.
+    // Следующее кратное после begin: begin + (mod - begin % mod)
+    uint64_t rest = args->begin % mod;
+    if (rest == 0 || args->end - args->begin >= mod - rest) {
+        *result = 0;
+        return true;
+    }
+
+    // Кратных внутри нет, поэтому множители можно взять по модулю:
+    // диапазон сжимается до [begin % mod, end % mod] длиной меньше mod
+    args->end = rest + (args->end - args->begin);
+    args->begin = rest;
+    return false;
+}
+
+uint64_t Factorial(const struct FactorialArgs *args) {
+    struct FactorialArgs reduced = *args;
+    uint64_t result;
+    if (FactorialReduce(&reduced, &result)) {
+        return result;
+    }
+
+    uint64_t begin = reduced.begin, end = reduced.end, mod = reduced.mod;
+    uint64_t direct = end - begin + 1;
+    // Для простого модуля [begin, end] = end! / (begin-1)!, и каждый из
+    // факториалов может оказаться дешевле через теорему Вильсона
+    if (direct >= WILSON_MIN_RANGE &&
+        PrefixCost(end, mod) + PrefixCost(begin - 1, mod) < direct && IsPrime(mod)) {
+        uint64_t numerator = PrimePrefix(end, mod);
+        uint64_t denominator = PrimePrefix(begin - 1, mod);
+        return MultModulo(numerator, PowModulo(denominator, mod - 2, mod), mod);
+    }
+    return DirectProduct(begin, end, mod);
+}
@@ -0,0 +1,22 @@
+#ifndef FACTORIAL_H
+#define FACTORIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Диапазон вычислений [begin, end] по модулю mod
+struct FactorialArgs {
+    uint64_t begin;  // Начало диапазона вычислений
+    uint64_t end;    // Конец диапазона вычислений
+    uint64_t mod;    // Модуль для вычислений
+};
+
+// Быстрый анализ без перемножения: true, если ответ известен сразу
+// (пустой диапазон или в нем есть кратное mod). Иначе сжимает диапазон
+// до эквивалентного с концами меньше mod
+bool FactorialReduce(struct FactorialArgs *args, uint64_t *result);
+
+// Произведение всех чисел диапазона по модулю
+uint64_t Factorial(const struct FactorialArgs *args);
+
+#endif // FACTORIAL_H
@@ -0,0 +1,178 @@
+#include "pool.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "utils.h"
+
+// Часть задания в очереди
+struct PoolTask {
+    struct FactorialJob *job;
+    uint64_t begin;
+    uint64_t end;
+};
+
+struct FactorialPool {
+    pthread_t *threads;
+    unsigned int threads_num;
+
+    // Кольцевой буфер задач фиксированного размера
+    struct PoolTask *queue;
+    unsigned int capacity;
+    unsigned int head;
+    unsigned int count;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    bool stop;
+};
+
+static void CompleteTask(struct FactorialJob *job, uint64_t partial) {
+    pthread_mutex_lock(&job->mutex);
+    job->result = MultModulo(job->result, partial, job->mod);
+    bool finished = --job->pending == 0;
+    pthread_mutex_unlock(&job->mutex);
+
+    // Колбэк вызывается без блокировки: владелец может сразу освободить задание
+    if (finished) {
+        job->on_done(job);
+    }
+}
+
+static void *Worker(void *arg) {
+    struct FactorialPool *pool = (struct FactorialPool *)arg;
+
+    while (true) {
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->count == 0 && !pool->stop) {
+            pthread_cond_wait(&pool->not_empty, &pool->mutex);
+        }
+        if (pool->count == 0 && pool->stop) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+        struct PoolTask task = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pthread_mutex_unlock(&pool->mutex);
+
+        struct FactorialArgs args = {task.begin, task.end, task.job->mod};
+        CompleteTask(task.job, Factorial(&args));
+    }
+    return NULL;
+}
+
+struct FactorialPool *FactorialPoolCreate(unsigned int threads, unsigned int queue_capacity) {
+    struct FactorialPool *pool = calloc(1, sizeof(struct FactorialPool));
+    if (pool == NULL)
+        return NULL;
+
+    pool->threads = malloc(sizeof(pthread_t) * threads);
+    pool->queue = malloc(sizeof(struct PoolTask) * queue_capacity);
+    pool->capacity = queue_capacity;
+    if (pool->threads == NULL || pool->queue == NULL) {
+        free(pool->threads);
+        free(pool->queue);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+
+    for (unsigned int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, Worker, pool) != 0) {
+            FactorialPoolDestroy(pool);
+            return NULL;
+        }
+        pool->threads_num++;
+    }
+    return pool;
+}
+
+void FactorialJobInit(struct FactorialJob *job) {
+    job->mod = 1;
+    job->result = 0;
+    job->pending = 0;
+    job->on_done = NULL;
+    job->ctx = NULL;
+    pthread_mutex_init(&job->mutex, NULL);
+}
+
+void FactorialJobDestroy(struct FactorialJob *job) {
+    pthread_mutex_destroy(&job->mutex);
+}
+
+// Частей не больше, чем потоков (и мест в очереди), и каждая не короче
+// POOL_INLINE_RANGE / 4
+static uint64_t CountParts(const struct FactorialPool *pool, const struct FactorialArgs *args) {
+    uint64_t length = args->end - args->begin + 1;
+    uint64_t parts = length / (POOL_INLINE_RANGE / 4);
+    if (parts > pool->threads_num) parts = pool->threads_num;
+    if (parts > pool->capacity) parts = pool->capacity;
+    if (parts == 0) parts = 1;
+    return parts;
+}
+
+// Счетчик частей выставляется до постановки в очередь, чтобы досрочное
+// завершение одной части не посчитал задание завершенным
+static void StartJob(struct FactorialJob *job, const struct FactorialArgs *args, uint64_t parts) {
+    pthread_mutex_lock(&job->mutex);
+    job->mod = args->mod;
+    job->result = 1 % args->mod;
+    job->pending = (unsigned int)parts;
+    pthread_mutex_unlock(&job->mutex);
+}
+
+// Ставит часть i из parts в очередь; вызывается под мьютексом пула
+static void EnqueuePart(struct FactorialPool *pool, struct FactorialJob *job,
+                        const struct FactorialArgs *args, uint64_t parts, uint64_t i) {
+    uint64_t range = (args->end - args->begin + 1) / parts;
+    struct PoolTask task;
+    task.job = job;
+    task.begin = args->begin + i * range;
+    task.end = (i == parts - 1) ? args->end : task.begin + range - 1;
+
+    pool->queue[(pool->head + pool->count) % pool->capacity] = task;
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+}
+
+bool FactorialPoolTrySubmit(struct FactorialPool *pool, struct FactorialJob *job,
+                            const struct FactorialArgs *args) {
+    uint64_t parts = CountParts(pool, args);
+
+    // Задание ставится целиком или не ставится вовсе: под мьютексом пула
+    // потоки не могут забрать части, поэтому счетчик выставляется здесь же
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->capacity - pool->count < parts) {
+        pthread_mutex_unlock(&pool->mutex);
+        return false;
+    }
+    StartJob(job, args, parts);
+    for (uint64_t i = 0; i < parts; i++) {
+        EnqueuePart(pool, job, args, parts, i);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return true;
+}
+
+bool FactorialPoolIsInline(const struct FactorialArgs *args) {
+    return args->begin > args->end || args->end - args->begin < POOL_INLINE_RANGE;
+}
+
+void FactorialPoolDestroy(struct FactorialPool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (unsigned int i = 0; i < pool->threads_num; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->not_empty);
+    free(pool->threads);
+    free(pool->queue);
+    free(pool);
+}
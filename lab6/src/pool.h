@@ -0,0 +1,45 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "factorial.h"
+
+// Диапазоны короче этого считаются сразу в вызывающем потоке
+#define POOL_INLINE_RANGE (1u << 16)
+
+// Задание: произведение диапазона, разбитого на части для потоков пула.
+// Память под задание принадлежит вызывающему и переиспользуется между
+// запросами; потоки пула ничего не выделяют.
+struct FactorialJob {
+    uint64_t mod;
+    uint64_t result;       // Произведение уже готовых частей
+    unsigned int pending;  // Сколько частей еще считается
+    pthread_mutex_t mutex;
+
+    // Вызывается потоком пула после последней части
+    void (*on_done)(struct FactorialJob *job);
+    void *ctx;
+};
+
+struct FactorialPool;
+
+// threads потоков и очередь на queue_capacity частей
+struct FactorialPool *FactorialPoolCreate(unsigned int threads, unsigned int queue_capacity);
+
+void FactorialJobInit(struct FactorialJob *job);
+void FactorialJobDestroy(struct FactorialJob *job);
+
+// Достаточно ли короток диапазон, чтобы считать его без пула
+bool FactorialPoolIsInline(const struct FactorialArgs *args);
+
+// Делит диапазон на части и ставит их в очередь без ожидания: если в очереди
+// нет места под все части, задание не ставится и возвращается false
+bool FactorialPoolTrySubmit(struct FactorialPool *pool, struct FactorialJob *job,
+                            const struct FactorialArgs *args);
+
+void FactorialPoolDestroy(struct FactorialPool *pool);
+
+#endif // POOL_H
@@ -0,0 +1,164 @@
+#include "protocol.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/types.h>
+
+void PutU32(uint8_t *buf, uint32_t value) {
+    for (int i = 3; i >= 0; i--) {
+        buf[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+void PutU64(uint8_t *buf, uint64_t value) {
+    for (int i = 7; i >= 0; i--) {
+        buf[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+uint32_t GetU32(const uint8_t *buf) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+uint64_t GetU64(const uint8_t *buf) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+void EncodeHeader(uint8_t *buf, uint8_t type, uint64_t request_id, uint32_t length) {
+    PutU32(buf, PROTO_MAGIC);
+    buf[4] = PROTO_VERSION;
+    buf[5] = type;
+    buf[6] = 0;
+    buf[7] = 0;
+    PutU64(buf + 8, request_id);
+    PutU32(buf + 16, length);
+}
+
+bool DecodeHeader(const uint8_t *buf, struct FrameHeader *header) {
+    if (GetU32(buf) != PROTO_MAGIC || buf[4] != PROTO_VERSION)
+        return false;
+    header->type = buf[5];
+    header->request_id = GetU64(buf + 8);
+    header->length = GetU32(buf + 16);
+    return header->length <= PROTO_MAX_PAYLOAD;
+}
+
+size_t RangeRequestSize(uint32_t count) {
+    return 12 + 16 * (size_t)count;
+}
+
+bool DecodeRangeRequest(const uint8_t *payload, uint32_t length, uint64_t *mod,
+                        struct Range *ranges, uint32_t *count) {
+    if (length < 12)
+        return false;
+    *mod = GetU64(payload);
+    *count = GetU32(payload + 8);
+    if (*mod == 0 || *count == 0 || *count > PROTO_MAX_RANGES ||
+        length != RangeRequestSize(*count))
+        return false;
+
+    for (uint32_t i = 0; i < *count; i++) {
+        ranges[i].begin = GetU64(payload + 12 + 16 * i);
+        ranges[i].end = GetU64(payload + 20 + 16 * i);
+    }
+    return true;
+}
+
+size_t BigIntPayloadSize(const struct BigInt *x) {
+    return 4 + 4 * x->len;
+}
+
+void EncodeBigInt(uint8_t *payload, const struct BigInt *x) {
+    PutU32(payload, (uint32_t)x->len);
+    for (size_t i = 0; i < x->len; i++) {
+        PutU32(payload + 4 + 4 * i, x->limbs[i]);
+    }
+}
+
+bool DecodeBigInt(const uint8_t *payload, uint32_t length, struct BigInt *x) {
+    if (length < 8)
+        return false;
+    uint32_t count = GetU32(payload);
+    if (count == 0 || length != 4 + 4 * (size_t)count)
+        return false;
+
+    x->limbs = malloc(sizeof(uint32_t) * count);
+    if (x->limbs == NULL)
+        return false;
+    x->len = count;
+    for (uint32_t i = 0; i < count; i++) {
+        x->limbs[i] = GetU32(payload + 4 + 4 * i);
+        if (x->limbs[i] >= BIGINT_BASE) {
+            BigIntFree(x);
+            return false;
+        }
+    }
+    // Старшие нулевые разряды не нужны
+    while (x->len > 1 && x->limbs[x->len - 1] == 0) x->len--;
+    return true;
+}
+
+static bool WriteAll(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool ReadAll(int fd, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool SendFrame(int fd, uint8_t type, uint64_t request_id, const uint8_t *payload,
+               uint32_t length) {
+    uint8_t header[PROTO_HEADER_SIZE];
+    EncodeHeader(header, type, request_id, length);
+
+    // Заголовок и нагрузка уходят одним вызовом, чтобы не ждать Нейгла
+    struct iovec iov[2] = {{header, sizeof(header)}, {(void *)payload, length}};
+    struct msghdr msg = {.msg_iov = iov, .msg_iovlen = 2};
+    ssize_t n;
+    do {
+        n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return false;
+
+    // Досылка, если ядро приняло кадр не целиком
+    size_t sent = n;
+    if (sent < sizeof(header)) {
+        return WriteAll(fd, header + sent, sizeof(header) - sent) &&
+               WriteAll(fd, payload, length);
+    }
+    sent -= sizeof(header);
+    return WriteAll(fd, payload + sent, length - sent);
+}
+
+bool RecvFrame(int fd, struct FrameHeader *header, uint8_t *payload) {
+    uint8_t buf[PROTO_HEADER_SIZE];
+    return ReadAll(fd, buf, sizeof(buf)) && DecodeHeader(buf, header) &&
+           ReadAll(fd, payload, header->length);
+}
@@ -0,0 +1,92 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bigint.h"
+
+// Кадр: заголовок фиксированного размера и полезная нагрузка.
+// Все числа передаются в сетевом порядке байт (big-endian).
+//
+//   0  u32 magic       PROTO_MAGIC
+//   4  u8  version     PROTO_VERSION
+//   5  u8  type        enum MessageType
+//   6  u16 reserved    0
+//   8  u64 request_id  ответ несет id запроса, ответы могут идти не по порядку
+//  16  u32 length      длина нагрузки
+#define PROTO_MAGIC 0x46414354u  // "FACT"
+#define PROTO_VERSION 1
+#define PROTO_HEADER_SIZE 20
+#define PROTO_MAX_PAYLOAD (1u << 24)
+
+// Диапазонов в одном пакетном запросе
+#define PROTO_MAX_RANGES 4096
+
+enum MessageType {
+    // Запрос без нагрузки; ответ: u32 threads, u64 throughput (чисел в секунду)
+    MSG_HELLO = 1,
+    // u64 mod, u32 count, count * (u64 begin, u64 end)
+    MSG_RANGE_REQUEST = 2,
+    // u32 count, count * u64 произведение диапазона, в порядке запроса
+    MSG_RANGE_RESPONSE = 3,
+    // u32 code, текст ошибки
+    MSG_ERROR = 4,
+    // Запрос без нагрузки; ответ: u64 hits, u64 prefix_hits, u64 misses, u64 entries
+    MSG_STATS = 5,
+    // Точное произведение: u64 begin, u64 end
+    MSG_EXACT_REQUEST = 6,
+    // u32 count, count * u32 разрядов по основанию 10^9, младшие первыми
+    MSG_EXACT_RESPONSE = 7,
+};
+
+enum ErrorCode {
+    ERR_BAD_FRAME = 1,
+    ERR_BAD_REQUEST = 2,
+    ERR_UNKNOWN_TYPE = 3,
+    ERR_BUSY = 4,  // Лимит одновременных запросов исчерпан, можно повторить позже
+};
+
+struct FrameHeader {
+    uint8_t type;
+    uint64_t request_id;
+    uint32_t length;
+};
+
+struct Range {
+    uint64_t begin;
+    uint64_t end;
+};
+
+void PutU32(uint8_t *buf, uint32_t value);
+void PutU64(uint8_t *buf, uint64_t value);
+uint32_t GetU32(const uint8_t *buf);
+uint64_t GetU64(const uint8_t *buf);
+
+void EncodeHeader(uint8_t *buf, uint8_t type, uint64_t request_id, uint32_t length);
+
+// Проверяет magic, версию и длину нагрузки
+bool DecodeHeader(const uint8_t *buf, struct FrameHeader *header);
+
+// Размер нагрузки запроса на count диапазонов
+size_t RangeRequestSize(uint32_t count);
+
+// Нагрузка запроса; false, если она некорректна. ranges - массив на
+// PROTO_MAX_RANGES элементов
+bool DecodeRangeRequest(const uint8_t *payload, uint32_t length, uint64_t *mod,
+                        struct Range *ranges, uint32_t *count);
+
+// Размер нагрузки MSG_EXACT_RESPONSE для числа x
+size_t BigIntPayloadSize(const struct BigInt *x);
+void EncodeBigInt(uint8_t *payload, const struct BigInt *x);
+// false, если нагрузка некорректна
+bool DecodeBigInt(const uint8_t *payload, uint32_t length, struct BigInt *x);
+
+// Блокирующие отправка и прием кадра целиком (для клиента)
+bool SendFrame(int fd, uint8_t type, uint64_t request_id, const uint8_t *payload,
+               uint32_t length);
+// payload - буфер на PROTO_MAX_PAYLOAD байт
+bool RecvFrame(int fd, struct FrameHeader *header, uint8_t *payload);
+
+#endif // PROTOCOL_H
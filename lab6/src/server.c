@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+#include <errno.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -7,40 +9,586 @@
 #include <getopt.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <pthread.h>
+#include <time.h>
+#include "bigint.h"
+#include "cache.h"
+#include "factorial.h"
+#include "pool.h"
+#include "protocol.h"
 #include "utils.h"
 
-// Структура для передачи аргументов в поток
-struct FactorialArgs {
-    uint64_t begin;  // Начало диапазона вычислений
-    uint64_t end;    // Конец диапазона вычислений
-    uint64_t mod;    // Модуль для вычислений
+// Самый длинный диапазон точного запроса
+#define EXACT_MAX_RANGE (1u << 22)
+// Точных запросов в работе на весь сервер и на одно соединение: каждый
+// занимает свой поток и еще hello_threads потоков дерева произведений
+#define EXACT_MAX_INFLIGHT 4
+#define EXACT_MAX_PER_CONN 1
+// Размер очереди частей на один поток пула
+#define TASKS_PER_THREAD 4
+// Сколько событий забирается из epoll за один вызов
+#define MAX_EVENTS 64
+
+// Буфер байтов соединения; pos - сколько уже разобрано или отправлено
+struct Buffer {
+    uint8_t *data;
+    size_t len;
+    size_t pos;
+    size_t cap;
+};
+
+// Постоянное соединение: запросы читаются и ответы пишутся неблокирующе,
+// несколько запросов могут считаться одновременно
+struct Connection {
+    int fd;
+    struct Buffer in;
+    struct Buffer out;
+    unsigned int inflight;  // Запросов, которые еще считаются в пуле
+    unsigned int exact_inflight;  // Из них точных
+    bool read_closed;       // Клиент закрыл соединение или прислал мусор
+    bool broken;            // Запись невозможна, ответы выбрасываются
+    uint32_t events;        // Текущая маска epoll (0 - не зарегистрирован)
+};
+
+struct Request;
+
+// Длинный диапазон из пакетного запроса, отданный в пул
+struct RangeJob {
+    struct FactorialJob job;
+    struct Request *request;
+    uint32_t index;
+    struct Range range;  // Сжатый запрошенный диапазон, для записи в кэш
+    uint64_t prefix;     // Произведение начала диапазона, найденное в кэше
+    struct FactorialArgs args;  // Что осталось посчитать в пуле
 };
 
-// Функция вычисления факториала в заданном диапазоне по модулю
-uint64_t Factorial(const struct FactorialArgs *args) {
-    uint64_t ans = 1;
-    // Умножение всех чисел в диапазоне [begin, end] по модулю mod
-    for (uint64_t i = args->begin; i <= args->end; i++) {
-        ans = MultModulo(ans, i, args->mod);  // Функция из utils.h
+// Пакетный запрос: ответ отправляется, когда посчитаны все диапазоны
+struct Request {
+    struct Connection *conn;
+    uint64_t id;
+    uint32_t count;
+    uint64_t results[PROTO_MAX_RANGES];
+    struct RangeJob *jobs;
+    unsigned int jobs_num;
+    unsigned int remaining;  // Уменьшается потоками пула атомарно
+    unsigned int submitted;  // Сколько заданий уже отдано в пул
+    struct Request *next_done;
+    struct Request *next_parked;
+
+    // Точный запрос считается в отдельном потоке
+    bool exact;
+    struct Range exact_range;
+    struct BigInt exact_result;
+};
+
+// Готовые запросы передаются из потоков пула в цикл событий через
+// список под мьютексом и eventfd, который будит epoll_wait
+static struct Request *done_list = NULL;
+static pthread_mutex_t done_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int done_fd = -1;
+
+// Запросы, задания которых не поместились в очередь пула. Цикл событий не
+// ждет места в очереди, а досылает задания, когда потоки пула сообщат о
+// готовности; resume_wanted просит их будить цикл после каждого задания
+static struct Request *parked_head = NULL;
+static struct Request *parked_tail = NULL;
+static bool resume_wanted = false;
+
+// Метки для событий слушающего сокета и eventfd
+static int listen_tag;
+static int done_tag;
+
+// Точных запросов в работе; меняется только в цикле событий
+static unsigned int exact_inflight = 0;
+
+// Кэш произведений; NULL, если отключен. Доступен только из цикла событий
+static struct RangeCache *cache = NULL;
+
+// Что сервер сообщает клиентам в HELLO
+static uint32_t hello_threads;
+static uint64_t hello_throughput;
+
+static double NowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Оценка производительности: сколько чисел в секунду перемножают все потоки
+static uint64_t MeasureThroughput(unsigned int threads) {
+    struct FactorialArgs args = {1, 1u << 22, 998244353};
+    double start = NowMs();
+    volatile uint64_t sink = Factorial(&args);
+    (void)sink;
+    double elapsed = NowMs() - start;
+    if (elapsed <= 0) elapsed = 1e-3;
+    return (uint64_t)(args.end / elapsed * 1000.0) * threads;
+}
+
+static bool BufferReserve(struct Buffer *buf, size_t extra) {
+    if (buf->len + extra <= buf->cap) return true;
+    // Сначала сдвигаем необработанный хвост в начало
+    if (buf->pos > 0) {
+        memmove(buf->data, buf->data + buf->pos, buf->len - buf->pos);
+        buf->len -= buf->pos;
+        buf->pos = 0;
+        if (buf->len + extra <= buf->cap) return true;
+    }
+    size_t cap = buf->cap ? buf->cap : 4096;
+    while (cap < buf->len + extra) cap *= 2;
+    uint8_t *data = realloc(buf->data, cap);
+    if (data == NULL) return false;
+    buf->data = data;
+    buf->cap = cap;
+    return true;
+}
+
+// Добавляет кадр в очередь на отправку; нагрузка пишется вызывающим
+static uint8_t *AppendFrame(struct Connection *conn, uint8_t type, uint64_t id, uint32_t length) {
+    if (conn->broken || !BufferReserve(&conn->out, PROTO_HEADER_SIZE + length)) return NULL;
+    uint8_t *frame = conn->out.data + conn->out.len;
+    EncodeHeader(frame, type, id, length);
+    conn->out.len += PROTO_HEADER_SIZE + length;
+    return frame + PROTO_HEADER_SIZE;
+}
+
+static void AppendError(struct Connection *conn, uint64_t id, uint32_t code, const char *text) {
+    uint32_t len = strlen(text);
+    uint8_t *payload = AppendFrame(conn, MSG_ERROR, id, 4 + len);
+    if (payload == NULL) return;
+    PutU32(payload, code);
+    memcpy(payload + 4, text, len);
+}
+
+static void AppendResults(struct Connection *conn, uint64_t id, const uint64_t *results,
+                          uint32_t count) {
+    uint8_t *payload = AppendFrame(conn, MSG_RANGE_RESPONSE, id, 4 + 8 * count);
+    if (payload == NULL) return;
+    PutU32(payload, count);
+    for (uint32_t i = 0; i < count; i++) {
+        PutU64(payload + 4 + 8 * i, results[i]);
+    }
+}
+
+static void AppendExact(struct Connection *conn, uint64_t id, const struct BigInt *x) {
+    size_t size = BigIntPayloadSize(x);
+    if (size > PROTO_MAX_PAYLOAD) {
+        AppendError(conn, id, ERR_BAD_REQUEST, "exact result too large");
+        return;
+    }
+    uint8_t *payload = AppendFrame(conn, MSG_EXACT_RESPONSE, id, size);
+    if (payload != NULL) EncodeBigInt(payload, x);
+}
+
+static void CloseConnection(struct Connection *conn) {
+    close(conn->fd);  // Закрытие также убирает сокет из epoll
+    free(conn->in.data);
+    free(conn->out.data);
+    free(conn);
+}
+
+// Приводит маску epoll в соответствие с состоянием соединения.
+// Возвращает false, если соединение больше не нужно
+static bool UpdateConnection(int epfd, struct Connection *conn) {
+    bool has_output = !conn->broken && conn->out.pos < conn->out.len;
+    if (conn->inflight == 0 && (conn->broken || (conn->read_closed && !has_output))) {
+        return false;
+    }
+
+    uint32_t events = 0;
+    if (!conn->read_closed) events |= EPOLLIN;
+    if (has_output) events |= EPOLLOUT;
+    if (events != conn->events) {
+        struct epoll_event ev = {.events = events, .data.ptr = conn};
+        int op = conn->events == 0 ? EPOLL_CTL_ADD : (events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD);
+        if (epoll_ctl(epfd, op, conn->fd, &ev) < 0) {
+            perror("epoll_ctl");
+            return false;
+        }
+        conn->events = events;
+    }
+    return true;
+}
+
+// Отправляет сколько получится из очереди ответов
+static void FlushOutput(struct Connection *conn) {
+    struct Buffer *out = &conn->out;
+    while (!conn->broken && out->pos < out->len) {
+        ssize_t n = send(conn->fd, out->data + out->pos, out->len - out->pos, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            conn->broken = true;
+            conn->read_closed = true;
+            break;
+        }
+        out->pos += n;
+    }
+    out->pos = out->len = 0;
+}
+
+static void PushDone(struct Request *request);
+
+static void WakeLoop(void) {
+    uint64_t one = 1;
+    if (write(done_fd, &one, sizeof(one)) < 0) {
+        perror("eventfd write");
+    }
+}
+
+static void OnJobDone(struct FactorialJob *job) {
+    struct RangeJob *range_job = (struct RangeJob *)job->ctx;
+    struct Request *request = range_job->request;
+    // Последняя часть уже записала результат под мьютексом задания
+    request->results[range_job->index] = MultModulo(range_job->prefix, job->result, job->mod);
+    if (__atomic_sub_fetch(&request->remaining, 1, __ATOMIC_ACQ_REL) != 0) {
+        // Очередь пула освободилась, а запрос еще не готов: без этого
+        // отложенные задания ждали бы завершения какого-нибудь запроса
+        if (__atomic_load_n(&resume_wanted, __ATOMIC_SEQ_CST)) WakeLoop();
+        return;
+    }
+    PushDone(request);
+}
+
+// Точное произведение считается деревом на hello_threads потоках
+static void *ExactThread(void *arg) {
+    struct Request *request = (struct Request *)arg;
+    request->exact_result = BigIntParallelRangeProduct(request->exact_range.begin,
+                                                       request->exact_range.end, hello_threads);
+    PushDone(request);
+    return NULL;
+}
+
+static void PushDone(struct Request *request) {
+    pthread_mutex_lock(&done_mutex);
+    request->next_done = done_list;
+    done_list = request;
+    pthread_mutex_unlock(&done_mutex);
+    WakeLoop();
+}
+
+static void FreeRequest(struct Request *request) {
+    for (unsigned int i = 0; i < request->jobs_num; i++) {
+        FactorialJobDestroy(&request->jobs[i].job);
+    }
+    free(request->jobs);
+    free(request);
+}
+
+static bool IsCacheable(const struct Range *range) {
+    return range->begin <= range->end && range->end - range->begin >= CACHE_MIN_RANGE;
+}
+
+// Запоминает в кэше диапазоны, посчитанные пулом
+static void CacheResults(const struct Request *request) {
+    if (cache == NULL) return;
+    for (unsigned int i = 0; i < request->jobs_num; i++) {
+        const struct RangeJob *range_job = &request->jobs[i];
+        if (IsCacheable(&range_job->range)) {
+            CacheInsert(cache, range_job->range.begin, range_job->range.end,
+                        range_job->job.mod, request->results[range_job->index]);
+        }
+    }
+}
+
+// Отдает в пул отложенные задания по порядку, пока в очереди есть место.
+// Флаг выставляется до попытки: задания, забранные из очереди после
+// неудачной попытки, увидят его и разбудят цикл событий
+static void ResumeParked(struct FactorialPool *pool) {
+    __atomic_store_n(&resume_wanted, true, __ATOMIC_SEQ_CST);
+    while (parked_head != NULL) {
+        struct Request *request = parked_head;
+        while (request->submitted < request->jobs_num) {
+            struct RangeJob *range_job = &request->jobs[request->submitted];
+            if (!FactorialPoolTrySubmit(pool, &range_job->job, &range_job->args)) return;
+            request->submitted++;
+        }
+        // Запрос освобождается только в FlushDone, на этом же потоке
+        parked_head = request->next_parked;
+        if (parked_head == NULL) parked_tail = NULL;
+    }
+    __atomic_store_n(&resume_wanted, false, __ATOMIC_SEQ_CST);
+}
+
+// Короткие диапазоны считаются сразу, длинные уходят в пул; ответ на
+// запрос без длинных диапазонов ставится в очередь немедленно
+static void HandleRangeRequest(struct FactorialPool *pool, struct Connection *conn,
+                               uint64_t id, const uint8_t *payload, uint32_t length) {
+    // Рабочие массивы на стеке цикла событий (около 200 КБ): функция
+    // вызывается только из него, общего состояния между запросами нет
+    struct Range ranges[PROTO_MAX_RANGES];
+    uint64_t mod;
+    uint32_t count;
+    if (!DecodeRangeRequest(payload, length, &mod, ranges, &count)) {
+        AppendError(conn, id, ERR_BAD_REQUEST, "malformed range request");
+        return;
+    }
+
+    struct Request *request = calloc(1, sizeof(struct Request));
+    if (request == NULL) {
+        AppendError(conn, id, ERR_BAD_REQUEST, "out of memory");
+        return;
+    }
+    request->conn = conn;
+    request->id = id;
+    request->count = count;
+
+    // Длинные диапазоны (или их хвосты после кэша) уходят в пул
+    struct FactorialArgs long_args[PROTO_MAX_RANGES];
+    uint64_t long_prefix[PROTO_MAX_RANGES];
+    uint32_t long_index[PROTO_MAX_RANGES];
+    unsigned int long_ranges = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        struct FactorialArgs args = {ranges[i].begin, ranges[i].end, mod};
+        // Нулевые и пустые диапазоны отвечаются сразу, остальные сжимаются
+        // по модулю; сжатый диапазон же служит ключом кэша
+        if (FactorialReduce(&args, &request->results[i])) continue;
+        ranges[i].begin = args.begin;
+        ranges[i].end = args.end;
+        uint64_t prefix = 1 % mod;
+
+        uint64_t covered_end;
+        if (cache != NULL && IsCacheable(&ranges[i]) &&
+            CacheLookup(cache, args.begin, args.end, mod, &covered_end, &prefix)) {
+            if (covered_end == args.end) {
+                request->results[i] = prefix;
+                continue;
+            }
+            args.begin = covered_end + 1;
+        }
+
+        if (FactorialPoolIsInline(&args)) {
+            request->results[i] = MultModulo(prefix, Factorial(&args), mod);
+            if (cache != NULL && IsCacheable(&ranges[i])) {
+                CacheInsert(cache, ranges[i].begin, ranges[i].end, mod, request->results[i]);
+            }
+        } else {
+            long_args[long_ranges] = args;
+            long_prefix[long_ranges] = prefix;
+            long_index[long_ranges] = i;
+            long_ranges++;
+        }
+    }
+
+    if (long_ranges == 0) {
+        AppendResults(conn, id, request->results, count);
+        free(request);
+        return;
+    }
+    request->jobs = calloc(long_ranges, sizeof(struct RangeJob));
+    if (request->jobs == NULL) {
+        free(request);
+        AppendError(conn, id, ERR_BAD_REQUEST, "out of memory");
+        return;
+    }
+
+    // Счетчик выставляется до отправки: задания могут завершиться сразу
+    request->remaining = long_ranges;
+    request->jobs_num = long_ranges;
+    conn->inflight++;
+    for (unsigned int j = 0; j < long_ranges; j++) {
+        struct RangeJob *range_job = &request->jobs[j];
+        FactorialJobInit(&range_job->job);
+        range_job->job.on_done = OnJobDone;
+        range_job->job.ctx = range_job;
+        range_job->request = request;
+        range_job->index = long_index[j];
+        range_job->range = ranges[long_index[j]];
+        range_job->prefix = long_prefix[j];
+        range_job->args = long_args[j];
+    }
+
+    // Задания встают в конец очереди отложенных, чтобы не обгонять
+    // запросы, которые уже ждут места в пуле
+    if (parked_tail != NULL) {
+        parked_tail->next_parked = request;
+    } else {
+        parked_head = request;
+    }
+    parked_tail = request;
+    ResumeParked(pool);
+}
+
+// Точный запрос: длинная арифметика не помещается в пул по модулю,
+// поэтому для каждого запроса заводится свой поток. Число таких потоков
+// ограничено, лишние запросы получают ERR_BUSY
+static void HandleExactRequest(struct Connection *conn, uint64_t id, const uint8_t *payload,
+                               uint32_t length) {
+    struct Range range;
+    if (length != 16) {
+        AppendError(conn, id, ERR_BAD_REQUEST, "malformed exact request");
+        return;
+    }
+    range.begin = GetU64(payload);
+    range.end = GetU64(payload + 8);
+    if (range.begin <= range.end && range.end - range.begin >= EXACT_MAX_RANGE) {
+        AppendError(conn, id, ERR_BAD_REQUEST, "exact range too long");
+        return;
+    }
+    if (exact_inflight >= EXACT_MAX_INFLIGHT || conn->exact_inflight >= EXACT_MAX_PER_CONN) {
+        AppendError(conn, id, ERR_BUSY, "too many exact requests in flight");
+        return;
+    }
+
+    struct Request *request = calloc(1, sizeof(struct Request));
+    if (request == NULL) {
+        AppendError(conn, id, ERR_BAD_REQUEST, "out of memory");
+        return;
+    }
+    request->conn = conn;
+    request->id = id;
+    request->exact = true;
+    request->exact_range = range;
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, ExactThread, request) != 0) {
+        free(request);
+        AppendError(conn, id, ERR_BAD_REQUEST, "unable to start exact computation");
+    } else {
+        conn->inflight++;
+        conn->exact_inflight++;
+        exact_inflight++;
     }
-    return ans;
+    pthread_attr_destroy(&attr);
 }
 
-// Функция, выполняемая в потоке
-void *ThreadFactorial(void *args) {
-    struct FactorialArgs *fargs = (struct FactorialArgs *)args;
-    // Выделяем память для результата (чтобы вернуть из потока)
-    uint64_t *result = malloc(sizeof(uint64_t));
-    *result = Factorial(fargs);  // Вычисляем факториал для своего диапазона
-    return (void *)result;       // Возвращаем указатель на результат
+static void HandleFrame(struct FactorialPool *pool, struct Connection *conn,
+                        const struct FrameHeader *header, const uint8_t *payload) {
+    switch (header->type) {
+    case MSG_HELLO: {
+        uint8_t *reply = AppendFrame(conn, MSG_HELLO, header->request_id, 12);
+        if (reply != NULL) {
+            PutU32(reply, hello_threads);
+            PutU64(reply + 4, hello_throughput);
+        }
+    } break;
+    case MSG_STATS: {
+        struct CacheStats stats;
+        CacheGetStats(cache, &stats);
+        uint8_t *reply = AppendFrame(conn, MSG_STATS, header->request_id, 32);
+        if (reply != NULL) {
+            PutU64(reply, stats.hits);
+            PutU64(reply + 8, stats.prefix_hits);
+            PutU64(reply + 16, stats.misses);
+            PutU64(reply + 24, stats.entries);
+        }
+    } break;
+    case MSG_EXACT_REQUEST:
+        HandleExactRequest(conn, header->request_id, payload, header->length);
+        break;
+    case MSG_RANGE_REQUEST:
+        HandleRangeRequest(pool, conn, header->request_id, payload, header->length);
+        break;
+    default:
+        AppendError(conn, header->request_id, ERR_UNKNOWN_TYPE, "unknown message type");
+    }
+}
+
+// Читает все доступные байты и обрабатывает полученные целиком кадры
+static void ReadRequests(struct FactorialPool *pool, struct Connection *conn) {
+    struct Buffer *in = &conn->in;
+    while (!conn->read_closed) {
+        if (!BufferReserve(in, 16384)) {
+            conn->broken = conn->read_closed = true;
+            return;
+        }
+        ssize_t n = recv(conn->fd, in->data + in->len, in->cap - in->len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) {
+            conn->read_closed = true;
+            break;
+        }
+        in->len += n;
+
+        while (in->len - in->pos >= PROTO_HEADER_SIZE) {
+            struct FrameHeader header;
+            if (!DecodeHeader(in->data + in->pos, &header)) {
+                // После испорченного заголовка границы кадров потеряны
+                AppendError(conn, 0, ERR_BAD_FRAME, "bad frame header");
+                conn->read_closed = true;
+                break;
+            }
+            if (in->len - in->pos < PROTO_HEADER_SIZE + header.length) break;
+            HandleFrame(pool, conn, &header, in->data + in->pos + PROTO_HEADER_SIZE);
+            in->pos += PROTO_HEADER_SIZE + header.length;
+        }
+    }
+}
+
+static void AcceptConnections(int epfd, int server_fd) {
+    while (true) {
+        int fd = accept4(server_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("Accept failed");
+            return;
+        }
+
+        // Ответы маленькие и идут подряд, их не нужно склеивать
+        int opt = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+        struct Connection *conn = calloc(1, sizeof(struct Connection));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        if (!UpdateConnection(epfd, conn)) CloseConnection(conn);
+    }
+}
+
+// Ставит в очередь ответы на запросы, завершенные потоками пула, и
+// досылает отложенные задания на освободившиеся места
+static void FlushDone(struct FactorialPool *pool, int epfd) {
+    uint64_t counter;
+    if (read(done_fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN) {
+        perror("eventfd read");
+    }
+
+    pthread_mutex_lock(&done_mutex);
+    struct Request *list = done_list;
+    done_list = NULL;
+    pthread_mutex_unlock(&done_mutex);
+
+    while (list != NULL) {
+        struct Request *request = list;
+        list = request->next_done;
+
+        struct Connection *conn = request->conn;
+        if (request->exact) {
+            AppendExact(conn, request->id, &request->exact_result);
+            BigIntFree(&request->exact_result);
+            conn->exact_inflight--;
+            exact_inflight--;
+        } else {
+            AppendResults(conn, request->id, request->results, request->count);
+        }
+        conn->inflight--;
+        CacheResults(request);
+        FreeRequest(request);
+
+        FlushOutput(conn);
+        if (!UpdateConnection(epfd, conn)) CloseConnection(conn);
+    }
+    if (parked_head != NULL) ResumeParked(pool);
 }
 
 int main(int argc, char **argv) {
     int tnum = -1;  // Количество потоков (по умолчанию -1)
     int port = -1;   // Порт сервера (по умолчанию -1)
+    int backlog = SOMAXCONN;  // Длина очереди входящих подключений
+    bool reuseport = false;   // Несколько экземпляров на одном порту
+    int cache_size = 4096;    // Записей в кэше произведений
 
     // Парсинг аргументов командной строки
     while (true) {
@@ -49,6 +597,9 @@ int main(int argc, char **argv) {
         static struct option options[] = {
             {"port", required_argument, 0, 0},  // Опция для порта
             {"tnum", required_argument, 0, 0},  // Опция для количества потоков
+            {"backlog", required_argument, 0, 0},
+            {"reuseport", no_argument, 0, 0},
+            {"cache", required_argument, 0, 0},  // Записей в кэше (0 - без кэша)
             {0, 0, 0, 0}
         };
 
@@ -67,6 +618,15 @@ int main(int argc, char **argv) {
             case 1:
                 tnum = atoi(optarg);  // Парсинг количества потоков
                 break;
+            case 2:
+                backlog = atoi(optarg);
+                break;
+            case 3:
+                reuseport = true;
+                break;
+            case 4:
+                cache_size = atoi(optarg);
+                break;
             default:
                 printf("Index %d is out of options\n", option_index);
             }
@@ -81,20 +641,47 @@ int main(int argc, char **argv) {
     }
 
     // Проверка обязательных аргументов
-    if (port == -1 || tnum == -1) {
-        fprintf(stderr, "Using: %s --port 20001 --tnum 4\n", argv[0]);
+    if (port == -1 || tnum <= 0 || cache_size < 0) {
+        fprintf(stderr,
+                "Using: %s --port 20001 --tnum 4 [--backlog N] [--reuseport] [--cache N]\n",
+                argv[0]);
         return 1;
     }
 
-    // Создание TCP сокета
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    // Потоки создаются один раз и живут все время работы сервера
+    struct FactorialPool *pool = FactorialPoolCreate(tnum, tnum * TASKS_PER_THREAD);
+    if (pool == NULL) {
+        fprintf(stderr, "Unable to create worker pool\n");
+        return 1;
+    }
+    hello_threads = tnum;
+    hello_throughput = MeasureThroughput(tnum);
+    if (cache_size > 0) {
+        cache = CacheCreate(cache_size);
+        if (cache == NULL) {
+            fprintf(stderr, "Unable to create cache\n");
+            return 1;
+        }
+    }
+
+    // Создание неблокирующего TCP сокета
+    int server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd < 0) {
         perror("Unable to create socket");
         return 1;
     }
 
+    int opt = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    // С SO_REUSEPORT ядро распределяет подключения между процессами на порту
+    if (reuseport && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("SO_REUSEPORT");
+        return 1;
+    }
+
     // Настройка адреса сервера
     struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;         // IPv4
     server_addr.sin_addr.s_addr = INADDR_ANY; // Принимаем соединения на все интерфейсы
     server_addr.sin_port = htons(port);       // Указанный порт
@@ -105,62 +692,61 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    // Ожидание подключений (максимум 3 в очереди)
-    listen(server_fd, 3);
-
-    // Основной цикл сервера
-    while (1) {
-        // Принятие нового подключения
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int new_socket = accept(server_fd, (struct sockaddr *)&client_addr, &client_len);
-
-        // Получение задачи от клиента (begin, end, mod)
-        uint64_t task[3];
-        recv(new_socket, task, sizeof(task), 0);
-
-        // Подготовка аргументов для вычислений
-        struct FactorialArgs fargs;
-        fargs.begin = task[0];
-        fargs.end = task[1];
-        fargs.mod = task[2];
-
-        pthread_t threads[tnum];    // Массив идентификаторов потоков
-        uint64_t results[tnum];    // Массив для результатов потоков
-
-        // Создание потоков
-        for (int i = 0; i < tnum; i++) {
-            // Вычисление диапазона для текущего потока
-            uint64_t range = (fargs.end - fargs.begin + 1) / tnum;
-            uint64_t start = fargs.begin + i * range;
-            uint64_t end = (i == tnum - 1) ? fargs.end : (start + range - 1);
+    if (listen(server_fd, backlog) < 0) {
+        perror("Listen failed");
+        return 1;
+    }
 
-            // Создание аргументов для потока
-            struct FactorialArgs *thread_args = malloc(sizeof(struct FactorialArgs));
-            *thread_args = (struct FactorialArgs){.begin = start, .end = end, .mod = fargs.mod};
+    done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (done_fd < 0 || epfd < 0) {
+        perror("Unable to create event loop");
+        return 1;
+    }
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = &listen_tag};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, server_fd, &ev);
+    ev.data.ptr = &done_tag;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, done_fd, &ev);
 
-            // Создание потока
-            pthread_create(&threads[i], NULL, ThreadFactorial, thread_args);
+    // Основной цикл сервера: подключения, кадры и ответы обрабатываются
+    // по готовности, пока длинные диапазоны считаются в пуле
+    struct epoll_event events[MAX_EVENTS];
+    while (1) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
         }
 
-        // Ожидание завершения всех потоков и сбор результатов
-        for (int i = 0; i < tnum; i++) {
-            void *result;
-            pthread_join(threads[i], &result);
-            results[i] = *(uint64_t *)result;
-            free(result);  // Освобождаем память, выделенную в потоке
-        }
+        // Готовые задания разбираются после остальных событий: FlushDone
+        // может закрыть соединение, событие которого еще в массиве
+        bool done_ready = false;
+        for (int i = 0; i < n; i++) {
+            void *tag = events[i].data.ptr;
+            if (tag == &listen_tag) {
+                AcceptConnections(epfd, server_fd);
+                continue;
+            }
+            if (tag == &done_tag) {
+                done_ready = true;
+                continue;
+            }
 
-        // Объединение результатов всех потоков
-        uint64_t final_result = 1;
-        for (int i = 0; i < tnum; i++) {
-            final_result = MultModulo(final_result, results[i], fargs.mod);
+            struct Connection *conn = (struct Connection *)tag;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                ReadRequests(pool, conn);
+            }
+            FlushOutput(conn);
+            if (!UpdateConnection(epfd, conn)) CloseConnection(conn);
         }
-
-        // Отправка результата клиенту
-        send(new_socket, &final_result, sizeof(final_result), 0);
-        close(new_socket);  // Закрытие соединения
+        if (done_ready) FlushDone(pool, epfd);
     }
 
+    close(epfd);
+    close(done_fd);
+    close(server_fd);
+    FactorialPoolDestroy(pool);
+    CacheDestroy(cache);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,185 @@
+#include <CUnit/Basic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "factorial.h"
+#include "utils.h"
+
+// Простые модули: 10^9 + 7, 998244353, 2^61 - 1 и наибольшее простое меньше 2^64
+#define MOD_1E9 1000000007ull
+#define MOD_NTT 998244353ull
+#define MOD_M61 ((1ull << 61) - 1)
+#define MOD_MAX 18446744073709551557ull
+
+void testMultModulo(void) {
+    CU_ASSERT_EQUAL(MultModulo(6, 7, 10), 2);
+    CU_ASSERT_EQUAL(MultModulo(0, 123, MOD_1E9), 0);
+    CU_ASSERT_EQUAL(MultModulo(5, 5, 1), 0);
+    // Множители и модуль около 2^64: произведение не помещается в 64 бита
+    CU_ASSERT_EQUAL(MultModulo((1ull << 63) + 5, (1ull << 63) + 7, MOD_MAX),
+                    13835058055282164927ull);
+    CU_ASSERT_EQUAL(MultModulo(UINT64_MAX, UINT64_MAX, MOD_MAX), 3364);
+}
+
+void testMultModuloMatchesSlow(void) {
+    // Побитовая версия удваивает a, поэтому сверяемся на модулях меньше 2^62
+    uint64_t mods[] = {3, MOD_1E9, MOD_NTT, (1ull << 62) - 57};
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 1000; j++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            uint64_t a = x % mods[i], b = (x >> 17) % mods[i];
+            CU_ASSERT_EQUAL(MultModulo(a, b, mods[i]), MultModuloSlow(a, b, mods[i]));
+        }
+    }
+}
+
+void testPowModulo(void) {
+    CU_ASSERT_EQUAL(PowModulo(2, 10, 1000), 24);
+    CU_ASSERT_EQUAL(PowModulo(12345, 0, MOD_1E9), 1);
+    CU_ASSERT_EQUAL(PowModulo(7, 5, 1), 0);
+    // Малая теорема Ферма: a^(p-1) = 1
+    CU_ASSERT_EQUAL(PowModulo(3, MOD_MAX - 1, MOD_MAX), 1);
+}
+
+void testIsPrime(void) {
+    CU_ASSERT_FALSE(IsPrime(0));
+    CU_ASSERT_FALSE(IsPrime(1));
+    CU_ASSERT_TRUE(IsPrime(2));
+    CU_ASSERT_TRUE(IsPrime(37));
+    CU_ASSERT_FALSE(IsPrime(561));  // Число Кармайкла
+    // Сильное псевдопростое по основаниям 2, 3, 5 и 7
+    CU_ASSERT_FALSE(IsPrime(3215031751ull));
+    CU_ASSERT_TRUE(IsPrime(MOD_1E9));
+    CU_ASSERT_TRUE(IsPrime(MOD_M61));
+    CU_ASSERT_TRUE(IsPrime(MOD_MAX));
+    CU_ASSERT_FALSE(IsPrime(MOD_M61 * 3));
+}
+
+void testMontgomeryInit(void) {
+    struct Montgomery m;
+    CU_ASSERT_FALSE(MontgomeryInit(&m, 1));
+    CU_ASSERT_FALSE(MontgomeryInit(&m, 1000));
+    CU_ASSERT_FALSE(MontgomeryInit(&m, (1ull << 63) + 1));
+    CU_ASSERT_TRUE_FATAL(MontgomeryInit(&m, MOD_M61));
+    // inv = -N^-1 mod 2^64, r = 2^64 mod N
+    CU_ASSERT_EQUAL(m.mod * m.inv, UINT64_MAX);
+    CU_ASSERT_EQUAL(m.r, 8);
+}
+
+void testMontgomeryMul(void) {
+    struct Montgomery m;
+    CU_ASSERT_TRUE_FATAL(MontgomeryInit(&m, MOD_M61));
+    uint64_t a = 123456789123456789ull, b = 987654321987654321ull;
+    // a * b * 2^-64 mod (2^61 - 1)
+    CU_ASSERT_EQUAL(MontgomeryMul(&m, a, b), 938120859584844577ull);
+    // Домножение на R снимает лишний множитель R^-1
+    CU_ASSERT_EQUAL(MultModulo(MontgomeryMul(&m, a, b), m.r, m.mod), MultModulo(a, b, m.mod));
+}
+
+void testMontgomeryRangeProduct(void) {
+    struct Montgomery m;
+    CU_ASSERT_TRUE_FATAL(MontgomeryInit(&m, MOD_1E9));
+    CU_ASSERT_EQUAL(MontgomeryRangeProduct(&m, 1, 20), 146326063);  // 20!
+    CU_ASSERT_EQUAL(MontgomeryRangeProduct(&m, 1, 100000), 457992974);
+    CU_ASSERT_EQUAL(MontgomeryRangeProduct(&m, 5, 4), 1);
+    CU_ASSERT_EQUAL(MontgomeryRangeProduct(&m, 0, 10), 0);
+    // Длины 1..7 проходят и четыре цепочки, и хвост
+    for (uint64_t end = 7; end < 14; end++) {
+        uint64_t expected = 1;
+        for (uint64_t i = 7; i <= end; i++) expected = MultModulo(expected, i, MOD_1E9);
+        CU_ASSERT_EQUAL(MontgomeryRangeProduct(&m, 7, end), expected);
+    }
+
+    CU_ASSERT_TRUE_FATAL(MontgomeryInit(&m, MOD_NTT));
+    CU_ASSERT_EQUAL(MontgomeryRangeProduct(&m, 500000, 1000000), 135176414);
+}
+
+void testFactorialReduce(void) {
+    uint64_t result;
+    // k >= mod: среди множителей есть сам mod
+    struct FactorialArgs args = {1, 20, 13};
+    CU_ASSERT_TRUE(FactorialReduce(&args, &result));
+    CU_ASSERT_EQUAL(result, 0);
+    args = (struct FactorialArgs){1, MOD_MAX, MOD_MAX};
+    CU_ASSERT_TRUE(FactorialReduce(&args, &result));
+    CU_ASSERT_EQUAL(result, 0);
+    // По модулю 1 любое произведение равно 0, пустое тоже
+    args = (struct FactorialArgs){1, 10, 1};
+    CU_ASSERT_TRUE(FactorialReduce(&args, &result));
+    CU_ASSERT_EQUAL(result, 0);
+    args = (struct FactorialArgs){5, 4, 1};
+    CU_ASSERT_TRUE(FactorialReduce(&args, &result));
+    CU_ASSERT_EQUAL(result, 0);
+    // Без кратных mod диапазон сжимается по модулю
+    args = (struct FactorialArgs){15, 20, 13};
+    CU_ASSERT_FALSE(FactorialReduce(&args, &result));
+    CU_ASSERT_EQUAL(args.begin, 2);
+    CU_ASSERT_EQUAL(args.end, 7);
+}
+
+// k! = -1 / ((k+1) * ... * (p-1)) по теореме Вильсона, как считает клиент
+static uint64_t WilsonFactorial(uint64_t k, uint64_t p) {
+    struct FactorialArgs suffix = {k + 1, p - 1, p};
+    return MultModulo(p - 1, PowModulo(Factorial(&suffix), p - 2, p), p);
+}
+
+void testFactorialWilson(void) {
+    // (p-1)! = p-1 и для клиента (пустой хвост), и для сервера
+    struct FactorialArgs args = {1, MOD_MAX - 1, MOD_MAX};
+    CU_ASSERT_EQUAL(Factorial(&args), MOD_MAX - 1);
+    CU_ASSERT_EQUAL(WilsonFactorial(MOD_MAX - 1, MOD_MAX), MOD_MAX - 1);
+    CU_ASSERT_EQUAL(WilsonFactorial(MOD_1E9 - 1, MOD_1E9), MOD_1E9 - 1);
+
+    args = (struct FactorialArgs){1, MOD_MAX - 10, MOD_MAX};
+    CU_ASSERT_EQUAL(Factorial(&args), 7286941751361450306ull);
+    CU_ASSERT_EQUAL(WilsonFactorial(MOD_MAX - 10, MOD_MAX), 7286941751361450306ull);
+
+    // Сверка с прямым перемножением
+    args = (struct FactorialArgs){1, MOD_NTT - 5000, MOD_NTT};
+    CU_ASSERT_EQUAL(Factorial(&args), WilsonFactorial(MOD_NTT - 5000, MOD_NTT));
+    uint64_t expected = 1;
+    for (uint64_t i = 1; i <= 100000; i++) expected = MultModulo(expected, i, MOD_1E9);
+    CU_ASSERT_EQUAL(WilsonFactorial(100000, MOD_1E9), expected);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry()) return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Modular arithmetic", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "MultModulo known answers", testMultModulo)) ||
+        (NULL == CU_add_test(pSuite, "MultModulo matches bit-serial version",
+                             testMultModuloMatchesSlow)) ||
+        (NULL == CU_add_test(pSuite, "PowModulo", testPowModulo)) ||
+        (NULL == CU_add_test(pSuite, "IsPrime", testIsPrime)) ||
+        (NULL == CU_add_test(pSuite, "MontgomeryInit", testMontgomeryInit)) ||
+        (NULL == CU_add_test(pSuite, "MontgomeryMul", testMontgomeryMul)) ||
+        (NULL == CU_add_test(pSuite, "MontgomeryRangeProduct known answers",
+                             testMontgomeryRangeProduct)) ||
+        (NULL == CU_add_test(pSuite, "FactorialReduce", testFactorialReduce)) ||
+        (NULL == CU_add_test(pSuite, "Factorial via Wilson's theorem",
+                             testFactorialWilson))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    /* make check должен падать на проваленных проверках */
+    unsigned int failures = CU_get_number_of_failures();
+    CU_cleanup_registry();
+    return failures > 0 ? 1 : CU_get_error();
+}
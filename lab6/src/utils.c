@@ -1,6 +1,10 @@
-#include <stdint.h>
+#include "utils.h"
 
 uint64_t MultModulo(uint64_t a, uint64_t b, uint64_t mod) {
+    return (uint64_t)((unsigned __int128)a * b % mod);
+}
+
+uint64_t MultModuloSlow(uint64_t a, uint64_t b, uint64_t mod) {
     uint64_t result = 0;
     a = a % mod;
     while (b > 0) {
@@ -10,4 +14,104 @@ uint64_t MultModulo(uint64_t a, uint64_t b, uint64_t mod) {
         b /= 2;
     }
     return result % mod;
-}
\ No newline at end of file
+}
+
+bool MontgomeryInit(struct Montgomery *m, uint64_t mod) {
+    if (mod % 2 == 0 || mod == 1 || mod >= (1ull << 63))
+        return false;
+
+    // Обратный к mod по модулю 2^64 методом Ньютона: каждый шаг удваивает
+    // число верных бит, для нечетного mod начальное приближение верно в 3 битах
+    uint64_t x = mod;
+    for (int i = 0; i < 5; i++)
+        x *= 2 - mod * x;
+
+    m->mod = mod;
+    m->inv = -x;
+    m->r = (uint64_t)(((unsigned __int128)1 << 64) % mod);
+    return true;
+}
+
+// Редукция Монтгомери: t * R^-1 mod N для t < N * R
+static inline uint64_t Reduce(const struct Montgomery *m, unsigned __int128 t) {
+    uint64_t k = (uint64_t)t * m->inv;
+    uint64_t u = (uint64_t)((t + (unsigned __int128)k * m->mod) >> 64);
+    return u >= m->mod ? u - m->mod : u;
+}
+
+uint64_t MontgomeryMul(const struct Montgomery *m, uint64_t a, uint64_t b) {
+    return Reduce(m, (unsigned __int128)a * b);
+}
+
+// base^exp mod N обычным возведением в степень
+uint64_t PowModulo(uint64_t base, uint64_t exp, uint64_t mod) {
+    uint64_t result = 1 % mod;
+    while (exp > 0) {
+        if (exp & 1)
+            result = MultModulo(result, base, mod);
+        base = MultModulo(base, base, mod);
+        exp >>= 1;
+    }
+    return result;
+}
+
+uint64_t MontgomeryRangeProduct(const struct Montgomery *m, uint64_t begin, uint64_t end) {
+    if (begin > end)
+        return 1;
+    if (begin == 0)
+        return 0;
+
+    // Каждое умножение Reduce(acc * i) дает acc * i * R^-1, поэтому после n
+    // множителей накапливается лишний множитель R^-n; он снимается в конце
+    // умножением на R^n. Четыре независимые цепочки скрывают латентность.
+    uint64_t acc[4] = {1, 1, 1, 1};
+    uint64_t n = end - begin + 1;
+    uint64_t left = n;
+    uint64_t i = begin;
+    for (; left >= 4; left -= 4, i += 4) {
+        acc[0] = Reduce(m, (unsigned __int128)acc[0] * i);
+        acc[1] = Reduce(m, (unsigned __int128)acc[1] * (i + 1));
+        acc[2] = Reduce(m, (unsigned __int128)acc[2] * (i + 2));
+        acc[3] = Reduce(m, (unsigned __int128)acc[3] * (i + 3));
+    }
+    for (; left > 0; left--, i++)
+        acc[0] = Reduce(m, (unsigned __int128)acc[0] * i);
+
+    uint64_t result = MultModulo(MultModulo(acc[0], acc[1], m->mod),
+                                 MultModulo(acc[2], acc[3], m->mod), m->mod);
+    return MultModulo(result, PowModulo(m->r, n, m->mod), m->mod);
+}
+
+bool IsPrime(uint64_t n) {
+    // Первых 12 простых оснований достаточно для всех n < 2^64
+    static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    if (n < 2)
+        return false;
+    for (int i = 0; i < 12; i++) {
+        if (n % bases[i] == 0)
+            return n == bases[i];
+    }
+
+    // n - 1 = d * 2^s
+    uint64_t d = n - 1;
+    int s = 0;
+    while (d % 2 == 0) {
+        d /= 2;
+        s++;
+    }
+
+    for (int i = 0; i < 12; i++) {
+        uint64_t x = PowModulo(bases[i], d, n);
+        if (x == 1 || x == n - 1)
+            continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; r++) {
+            x = MultModulo(x, x, n);
+            if (x == n - 1)
+                composite = false;
+        }
+        if (composite)
+            return false;
+    }
+    return true;
+}
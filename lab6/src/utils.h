@@ -1,8 +1,35 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+// a * b mod mod через 128-битное произведение: одно деление на умножение
 uint64_t MultModulo(uint64_t a, uint64_t b, uint64_t mod);
 
-#endif // UTILS_H
\ No newline at end of file
+// Прежняя побитовая реализация (сложения с удвоением), оставлена для сверки
+uint64_t MultModuloSlow(uint64_t a, uint64_t b, uint64_t mod);
+
+// base^exp mod mod
+uint64_t PowModulo(uint64_t base, uint64_t exp, uint64_t mod);
+
+// Детерминированный тест Миллера-Рабина для любого 64-битного n
+bool IsPrime(uint64_t n);
+
+// Параметры умножения Монтгомери для фиксированного нечетного модуля
+struct Montgomery {
+    uint64_t mod;   // N
+    uint64_t inv;   // -N^-1 mod 2^64
+    uint64_t r;     // R mod N, R = 2^64
+};
+
+// Возвращает false, если модуль четный, равен 1 или не меньше 2^63
+bool MontgomeryInit(struct Montgomery *m, uint64_t mod);
+
+// a * b * R^-1 mod N, требуется a * b < N * R
+uint64_t MontgomeryMul(const struct Montgomery *m, uint64_t a, uint64_t b);
+
+// Произведение чисел из [begin, end] по модулю N без делений в цикле
+uint64_t MontgomeryRangeProduct(const struct Montgomery *m, uint64_t begin, uint64_t end);
+
+#endif // UTILS_H
@@ -0,0 +1,61 @@
+#include "histogram.h"
+
+#include <string.h>
+
+static unsigned int BucketIndex(uint64_t value) {
+    if (value < HIST_SUB_COUNT) return (unsigned int)value;
+    unsigned int shift = 63 - __builtin_clzll(value) - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB_COUNT + (unsigned int)(value >> shift) - HIST_SUB_COUNT;
+}
+
+// Верхняя граница значений, попадающих в корзину
+static uint64_t BucketHighest(unsigned int index) {
+    if (index < 2 * HIST_SUB_COUNT) return index;
+    unsigned int shift = index / HIST_SUB_COUNT - 1;
+    uint64_t sub = index % HIST_SUB_COUNT + HIST_SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+void HistogramInit(struct Histogram *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+void HistogramRecord(struct Histogram *h, uint64_t value) {
+    h->counts[BucketIndex(value)]++;
+    h->total++;
+    h->sum += (double)value;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+}
+
+void HistogramMerge(struct Histogram *dst, const struct Histogram *src) {
+    for (unsigned int i = 0; i < HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t HistogramPercentile(const struct Histogram *h, double p) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * h->total + 0.5);
+    if (rank == 0) rank = 1;
+    if (rank > h->total) rank = h->total;
+
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t value = BucketHighest(i);
+            return value < h->max ? value : h->max;
+        }
+    }
+    return h->max;
+}
+
+double HistogramMean(const struct Histogram *h) {
+    return h->total ? h->sum / h->total : 0.0;
+}
@@ -0,0 +1,34 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+// Корзин на каждую степень двойки: относительная погрешность < 1/128
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1u << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+
+// Гистограмма в духе HdrHistogram: значения до 2^HIST_SUB_BITS хранятся
+// точно, дальше каждая степень двойки делится на HIST_SUB_COUNT равных
+// корзин. Запись - O(1) без ветвлений по диапазону, слияние - сложение
+// счетчиков. Гистограмма не потокобезопасна: у каждого потока своя
+struct Histogram {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+};
+
+void HistogramInit(struct Histogram *h);
+
+void HistogramRecord(struct Histogram *h, uint64_t value);
+
+void HistogramMerge(struct Histogram *dst, const struct Histogram *src);
+
+// Наибольшее значение, эквивалентное p-му перцентилю (0 < p <= 100)
+uint64_t HistogramPercentile(const struct Histogram *h, double p);
+
+double HistogramMean(const struct Histogram *h);
+
+#endif // HISTOGRAM_H
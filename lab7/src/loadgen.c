@@ -0,0 +1,419 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "histogram.h"
+
+#define SADDR struct sockaddr
+#define SIZE sizeof(struct sockaddr_in)
+#define MAX_EVENTS 64
+#define CACHE_LINE_SIZE 64
+// Сообщений в буферах отправки и приема TCP-потока
+#define FLOW_WINDOW 64
+// Сколько ждать ответов после окончания отправки
+#define DRAIN_NS 2000000000ULL
+// В замкнутом цикле ответ UDP считается потерянным через это время
+#define RESEND_NS 1000000000ULL
+
+// Заголовок каждого сообщения, дальше - заполнитель до --size байт.
+// Сервер возвращает сообщение без изменений
+struct MessageHeader {
+    uint64_t timestamp;  // Плановое время отправки, нс CLOCK_MONOTONIC
+    uint64_t seq;
+};
+
+struct Options {
+    struct sockaddr_in addr;
+    bool udp;
+    int connections;
+    int threads;
+    size_t size;
+    double rate;  // Сообщений в секунду на все потоки; 0 - замкнутый цикл
+    double duration;
+};
+
+// Одно соединение TCP или один поток UDP-датаграмм
+struct Flow {
+    int fd;
+    uint64_t next_due;  // Когда по расписанию уходит следующее сообщение
+    uint64_t sent;
+    uint64_t received;
+    uint64_t last_sent;
+    bool want_out;      // Ждем EPOLLOUT: буфер отправки сокета полон
+    char *out;          // Еще не записанные в сокет байты (TCP)
+    size_t out_off;
+    size_t out_len;
+    char *in;           // Неполное сообщение из потока (TCP)
+    size_t in_len;
+};
+
+struct Worker {
+    pthread_t thread;
+    int epfd;
+    struct Flow *flows;
+    int flows_num;
+    uint64_t errors;
+    struct Histogram hist;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static struct Options opts = {.connections = 1, .threads = 1, .size = 64, .duration = 5};
+static uint64_t interval_ns;  // Интервал между сообщениями одного потока
+static uint64_t start_ns;
+static uint64_t stop_ns;
+
+static void Usage(const char *name) {
+    printf("Usage: %s [--udp] [--connections N] [--threads N] [--size BYTES]\n"
+           "       [--rate MSG/S] [--duration SEC] <IP address> <port>\n", name);
+    exit(1);
+}
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int ConnectFlow(void) {
+    int fd = socket(AF_INET, opts.udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket creating");
+        exit(1);
+    }
+    if (connect(fd, (SADDR *)&opts.addr, SIZE) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    if (!opts.udp) {
+        int opt = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+static void RecordReply(struct Worker *w, struct Flow *f, const char *msg, uint64_t now) {
+    struct MessageHeader hdr;
+    memcpy(&hdr, msg, sizeof(hdr));
+    HistogramRecord(&w->hist, now > hdr.timestamp ? now - hdr.timestamp : 0);
+    f->received++;
+}
+
+static void Watch(struct Worker *w, struct Flow *f, bool want_out) {
+    if (f->want_out == want_out) return;
+    f->want_out = want_out;
+    struct epoll_event ev = {.events = EPOLLIN | (want_out ? EPOLLOUT : 0), .data.ptr = f};
+    epoll_ctl(w->epfd, EPOLL_CTL_MOD, f->fd, &ev);
+}
+
+static void FlushFlow(struct Worker *w, struct Flow *f) {
+    while (f->out_off < f->out_len) {
+        ssize_t n = write(f->fd, f->out + f->out_off, f->out_len - f->out_off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            Watch(w, f, true);
+            return;
+        }
+        if (n < 0) {
+            w->errors++;
+            f->out_off = f->out_len;
+            break;
+        }
+        f->out_off += n;
+    }
+    f->out_off = f->out_len = 0;
+    Watch(w, f, false);
+}
+
+// Ставит сообщение в очередь (TCP) или сразу отправляет (UDP).
+// false - отправить сейчас нельзя, сообщение остается в расписании
+static bool SendMessage(struct Worker *w, struct Flow *f, uint64_t timestamp) {
+    struct MessageHeader hdr = {timestamp, f->sent};
+
+    if (opts.udp) {
+        memcpy(f->out, &hdr, sizeof(hdr));
+        if (send(f->fd, f->out, opts.size, 0) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) return false;
+            w->errors++;  // Например, ICMP port unreachable от прошлой датаграммы
+        }
+    } else {
+        if (f->out_len + opts.size > FLOW_WINDOW * opts.size) {
+            if (f->out_off == 0) return false;
+            memmove(f->out, f->out + f->out_off, f->out_len - f->out_off);
+            f->out_len -= f->out_off;
+            f->out_off = 0;
+        }
+        memcpy(f->out + f->out_len, &hdr, sizeof(hdr));
+        memset(f->out + f->out_len + sizeof(hdr), 'x', opts.size - sizeof(hdr));
+        f->out_len += opts.size;
+    }
+    f->sent++;
+    f->last_sent = NowNs();
+    return true;
+}
+
+// Открытый цикл: сообщения уходят по расписанию независимо от ответов, а
+// задержка считается от планового времени. Так медленный ответ сервера не
+// откладывает следующие замеры и не прячется из хвоста распределения
+static void ScheduleFlow(struct Worker *w, struct Flow *f, uint64_t now) {
+    if (opts.rate > 0) {
+        while (f->next_due <= now && f->next_due < stop_ns) {
+            if (!SendMessage(w, f, f->next_due)) break;
+            f->next_due += interval_ns;
+        }
+    } else if (now < stop_ns &&
+               (f->sent == f->received || (opts.udp && now - f->last_sent > RESEND_NS))) {
+        SendMessage(w, f, now);
+    }
+    if (!opts.udp && f->out_len > f->out_off && !f->want_out) FlushFlow(w, f);
+}
+
+// false, если сервер закрыл соединение
+static bool ReceiveFlow(struct Worker *w, struct Flow *f) {
+    while (1) {
+        ssize_t n;
+        if (opts.udp) {
+            n = recv(f->fd, f->in, opts.size, 0);
+        } else {
+            n = read(f->fd, f->in + f->in_len, FLOW_WINDOW * opts.size - f->in_len);
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n < 0 && opts.udp) {
+            w->errors++;
+            continue;
+        }
+        if (n <= 0) return false;
+
+        uint64_t now = NowNs();
+        if (opts.udp) {
+            if ((size_t)n >= sizeof(struct MessageHeader)) RecordReply(w, f, f->in, now);
+            continue;
+        }
+
+        f->in_len += n;
+        size_t off = 0;
+        for (; f->in_len - off >= opts.size; off += opts.size) {
+            RecordReply(w, f, f->in + off, now);
+        }
+        memmove(f->in, f->in + off, f->in_len - off);
+        f->in_len -= off;
+    }
+}
+
+static bool Drained(const struct Worker *w) {
+    for (int i = 0; i < w->flows_num; i++) {
+        if (w->flows[i].received < w->flows[i].sent) return false;
+    }
+    return true;
+}
+
+static void *WorkerLoop(void *arg) {
+    struct Worker *w = (struct Worker *)arg;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (1) {
+        uint64_t now = NowNs();
+        if (now >= stop_ns && (Drained(w) || now >= stop_ns + DRAIN_NS)) break;
+
+        uint64_t wake = now < stop_ns ? stop_ns : stop_ns + DRAIN_NS;
+        for (int i = 0; i < w->flows_num; i++) {
+            struct Flow *f = &w->flows[i];
+            ScheduleFlow(w, f, now);
+            if (opts.rate > 0 && f->next_due < wake) wake = f->next_due;
+        }
+        if (opts.rate == 0 && now < stop_ns && now + RESEND_NS < wake) wake = now + RESEND_NS;
+
+        // Миллисекундного таймаута epoll мало для частых сообщений:
+        // округляем вниз, последнюю миллисекунду опрашиваем без сна
+        now = NowNs();
+        int timeout = wake > now ? (int)((wake - now) / 1000000) : 0;
+        int n = epoll_wait(w->epfd, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            exit(1);
+        }
+        for (int i = 0; i < n; i++) {
+            struct Flow *f = events[i].data.ptr;
+            if (events[i].events & EPOLLOUT) FlushFlow(w, f);
+            if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !ReceiveFlow(w, f)) {
+                fprintf(stderr, "server closed connection\n");
+                exit(1);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void PrintReport(struct Worker *workers, double elapsed) {
+    uint64_t sent = 0, received = 0, errors = 0;
+    struct Histogram *hist = malloc(sizeof(struct Histogram));
+    if (hist == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    HistogramInit(hist);
+    for (int t = 0; t < opts.threads; t++) {
+        for (int i = 0; i < workers[t].flows_num; i++) {
+            sent += workers[t].flows[i].sent;
+            received += workers[t].flows[i].received;
+        }
+        errors += workers[t].errors;
+        HistogramMerge(hist, &workers[t].hist);
+    }
+
+    printf("{\n");
+    printf("  \"proto\": \"%s\",\n", opts.udp ? "udp" : "tcp");
+    printf("  \"connections\": %d,\n", opts.connections);
+    printf("  \"threads\": %d,\n", opts.threads);
+    printf("  \"size\": %zu,\n", opts.size);
+    printf("  \"rate\": %.0f,\n", opts.rate);
+    printf("  \"duration\": %.3f,\n", elapsed);
+    printf("  \"sent\": %llu,\n", (unsigned long long)sent);
+    printf("  \"received\": %llu,\n", (unsigned long long)received);
+    printf("  \"lost\": %llu,\n", (unsigned long long)(sent > received ? sent - received : 0));
+    printf("  \"errors\": %llu,\n", (unsigned long long)errors);
+    printf("  \"throughput\": {\"msgs_per_sec\": %.1f, \"mbit_per_sec\": %.3f},\n",
+           received / elapsed, received * opts.size * 8 / elapsed / 1e6);
+    printf("  \"rtt_us\": {\"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+           "\"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f}\n",
+           (hist->total ? hist->min : 0) / 1e3, HistogramMean(hist) / 1e3,
+           HistogramPercentile(hist, 50) / 1e3, HistogramPercentile(hist, 90) / 1e3,
+           HistogramPercentile(hist, 99) / 1e3, HistogramPercentile(hist, 99.9) / 1e3,
+           hist->max / 1e3);
+    printf("}\n");
+    free(hist);
+}
+
+int main(int argc, char *argv[]) {
+    static struct option options[] = {
+        {"udp", no_argument, 0, 'u'},
+        {"connections", required_argument, 0, 'c'},
+        {"threads", required_argument, 0, 't'},
+        {"size", required_argument, 0, 's'},
+        {"rate", required_argument, 0, 'r'},
+        {"duration", required_argument, 0, 'd'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (c) {
+        case 'u':
+            opts.udp = true;
+            break;
+        case 'c':
+            opts.connections = atoi(optarg);
+            break;
+        case 't':
+            opts.threads = atoi(optarg);
+            break;
+        case 's':
+            opts.size = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            opts.rate = atof(optarg);
+            break;
+        case 'd':
+            opts.duration = atof(optarg);
+            break;
+        default:
+            Usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 2 || opts.connections <= 0 || opts.threads <= 0 ||
+        opts.size < sizeof(struct MessageHeader) || opts.size > 65507 ||
+        opts.rate < 0 || opts.duration <= 0) {
+        Usage(argv[0]);
+    }
+    if (opts.threads > opts.connections) opts.threads = opts.connections;
+
+    memset(&opts.addr, 0, SIZE);
+    opts.addr.sin_family = AF_INET;
+    opts.addr.sin_port = htons(atoi(argv[optind + 1]));
+    if (inet_pton(AF_INET, argv[optind], &opts.addr.sin_addr) <= 0) {
+        fprintf(stderr, "bad address %s\n", argv[optind]);
+        exit(1);
+    }
+
+    struct Worker *workers = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct Worker) * opts.threads);
+    struct Flow *flows = calloc(opts.connections, sizeof(struct Flow));
+    if (workers == NULL || flows == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    memset(workers, 0, sizeof(struct Worker) * opts.threads);
+
+    // Соединения делятся между потоками непрерывными кусками
+    for (int t = 0, first = 0; t < opts.threads; t++) {
+        struct Worker *w = &workers[t];
+        w->flows = flows + first;
+        w->flows_num = opts.connections / opts.threads + (t < opts.connections % opts.threads);
+        first += w->flows_num;
+        HistogramInit(&w->hist);
+        if ((w->epfd = epoll_create1(0)) < 0) {
+            perror("epoll_create1");
+            exit(1);
+        }
+    }
+
+    if (opts.rate > 0) interval_ns = (uint64_t)(1e9 * opts.connections / opts.rate);
+    if (interval_ns == 0) interval_ns = 1;
+    for (int t = 0; t < opts.threads; t++) {
+        for (int i = 0; i < workers[t].flows_num; i++) {
+            struct Flow *f = &workers[t].flows[i];
+            f->fd = ConnectFlow();
+            f->out = malloc(FLOW_WINDOW * opts.size);
+            f->in = malloc(FLOW_WINDOW * opts.size);
+            if (f->out == NULL || f->in == NULL) {
+                perror("malloc");
+                exit(1);
+            }
+            memset(f->out, 'x', FLOW_WINDOW * opts.size);
+            struct epoll_event ev = {.events = EPOLLIN, .data.ptr = f};
+            epoll_ctl(workers[t].epfd, EPOLL_CTL_ADD, f->fd, &ev);
+        }
+    }
+
+    start_ns = NowNs();
+    stop_ns = start_ns + (uint64_t)(opts.duration * 1e9);
+    // Потоки стартуют вразнобой, чтобы не слать сообщения залпами
+    for (int i = 0; i < opts.connections; i++) {
+        flows[i].next_due = start_ns + interval_ns * i / opts.connections;
+    }
+
+    for (int t = 0; t < opts.threads; t++) {
+        if (pthread_create(&workers[t].thread, NULL, WorkerLoop, &workers[t]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (int t = 0; t < opts.threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+    }
+
+    PrintReport(workers, opts.duration);
+
+    for (int i = 0; i < opts.connections; i++) {
+        close(flows[i].fd);
+        free(flows[i].out);
+        free(flows[i].in);
+    }
+    free(flows);
+    free(workers);
+    return 0;
+}
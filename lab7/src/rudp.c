@@ -0,0 +1,540 @@
+#include "rudp.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+enum PacketType {
+    PACKET_DATA = 1,
+    PACKET_ACK = 2,
+};
+
+#define FLAG_FIN 1
+
+// Заголовок: u8 type, u8 flags, u16 count, u32 seq (сетевой порядок).
+// DATA: count - длина данных, seq - номер датаграммы.
+// ACK: count - число блоков SACK, seq - первый еще не полученный номер;
+// дальше u32 правый край окна приема (первый номер, который получатель
+// уже не примет) и блоки [begin, end) по 8 байт. ACK отправителя, которому
+// нечего слать, служит получателю признаком жизни (RudpKeepalive)
+#define HEADER_SIZE 8
+#define ACK_SIZE (HEADER_SIZE + 4)
+#define MAX_DATAGRAM (HEADER_SIZE + RUDP_MAX_PAYLOAD)
+#define MAX_ACK (ACK_SIZE + 8 * RUDP_MAX_SACK)
+
+#define NSEC 1000000000ULL
+#define INITIAL_RTO_NS (200 * 1000000ULL)
+// Ниже рекомендованной RFC 6298 секунды: рассчитано на loopback и LAN
+#define MIN_RTO_NS (10 * 1000000ULL)
+#define MAX_RTO_NS (2 * NSEC)
+#define RTO_GRANULARITY_NS 1000000ULL
+#define MAX_RETRIES 16
+// Сколько датаграмм выше дыры должен подтвердить SACK для быстрого повтора
+#define DUP_THRESH 3
+#define REORDER_DELAY_NS (2 * 1000000ULL)
+#define LINGER_NS NSEC
+// Получатель, который столько не слышал собеседника, бросает соединение:
+// отправитель с данными в полете повторяет их не реже раза в MAX_RTO_NS,
+// а без данных шлет keepalive раз в RUDP_KEEPALIVE_MS
+#define IDLE_TIMEOUT_NS (8 * MAX_RTO_NS)
+
+struct SendSlot {
+    uint32_t seq;
+    uint16_t len;
+    uint8_t flags;
+    bool sacked;
+    bool retransmitted;  // По Карну RTT по таким не измеряется
+    unsigned int retries;
+    uint64_t sent_at;
+    char data[RUDP_MAX_PAYLOAD];
+};
+
+struct RecvSlot {
+    bool present;
+    uint8_t flags;
+    uint16_t len;
+    char data[RUDP_MAX_PAYLOAD];
+};
+
+struct RudpConn {
+    int fd;
+    struct sockaddr_in peer;
+    bool has_peer;
+    uint64_t last_heard;  // Когда от собеседника пришла последняя датаграмма
+    uint64_t last_sent;   // Когда собеседнику ушла последняя датаграмма
+    struct RudpOptions opts;
+    uint64_t rng;
+    int error;
+
+    // Отправка: [snd_base, snd_next) - в полете
+    struct SendSlot *snd;
+    uint32_t snd_base;
+    uint32_t snd_next;
+    uint32_t snd_limit;  // Правый край окна получателя из последнего ACK
+    uint64_t srtt;
+    uint64_t rttvar;
+    uint64_t rto;
+    bool has_rtt;
+
+    // Прием: [rcv_read, rcv_next) - получено подряд, но не прочитано
+    struct RecvSlot *rcv;
+    uint32_t rcv_read;
+    uint32_t rcv_next;
+    uint16_t read_off;
+    bool fin_received;
+    bool ack_pending;
+
+    // Придержанная имитатором датаграмма
+    char held[MAX_DATAGRAM];
+    size_t held_len;
+    uint64_t held_at;
+
+    struct RudpStats stats;
+};
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC + ts.tv_nsec;
+}
+
+// Номера датаграмм сравниваются по модулю 2^32
+static bool SeqBefore(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+static void PutU16(char *p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+static void PutU32(char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = v >> (24 - 8 * i);
+}
+
+static uint16_t GetU16(const char *p) {
+    return (uint16_t)((uint8_t)p[0] << 8 | (uint8_t)p[1]);
+}
+
+static uint32_t GetU32(const char *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v = v << 8 | (uint8_t)p[i];
+    return v;
+}
+
+// xorshift64*: только для имитатора потерь
+static double Random(struct RudpConn *conn) {
+    conn->rng ^= conn->rng >> 12;
+    conn->rng ^= conn->rng << 25;
+    conn->rng ^= conn->rng >> 27;
+    return (conn->rng * 0x2545F4914F6CDD1DULL >> 11) * (1.0 / (1ULL << 53));
+}
+
+static void SendDatagram(struct RudpConn *conn, const char *buf, size_t len) {
+    // ECONNREFUSED и переполнение буфера - та же потеря, ее закроет повтор
+    sendto(conn->fd, buf, len, 0, (const struct sockaddr *)&conn->peer, sizeof(conn->peer));
+}
+
+static void FlushHeld(struct RudpConn *conn) {
+    if (conn->held_len == 0) return;
+    SendDatagram(conn, conn->held, conn->held_len);
+    conn->held_len = 0;
+}
+
+// Вся отправка идет через имитатор: потеря или перестановка с соседней
+static void RawSend(struct RudpConn *conn, const char *buf, size_t len) {
+    conn->last_sent = NowNs();
+    if (conn->opts.loss > 0 && Random(conn) < conn->opts.loss) {
+        conn->stats.shim_dropped++;
+        return;
+    }
+    if (conn->opts.reorder > 0 && conn->held_len == 0 && Random(conn) < conn->opts.reorder) {
+        memcpy(conn->held, buf, len);
+        conn->held_len = len;
+        conn->held_at = NowNs();
+        conn->stats.shim_reordered++;
+        return;
+    }
+    SendDatagram(conn, buf, len);
+    FlushHeld(conn);
+}
+
+static void TransmitSlot(struct RudpConn *conn, struct SendSlot *slot, uint64_t now) {
+    char buf[MAX_DATAGRAM];
+    buf[0] = PACKET_DATA;
+    buf[1] = slot->flags;
+    PutU16(buf + 2, slot->len);
+    PutU32(buf + 4, slot->seq);
+    memcpy(buf + HEADER_SIZE, slot->data, slot->len);
+    RawSend(conn, buf, HEADER_SIZE + slot->len);
+    slot->sent_at = now;
+    conn->stats.data_sent++;
+}
+
+static void Retransmit(struct RudpConn *conn, struct SendSlot *slot, uint64_t now) {
+    if (++slot->retries > MAX_RETRIES) {
+        conn->error = ETIMEDOUT;
+        return;
+    }
+    slot->retransmitted = true;
+    TransmitSlot(conn, slot, now);
+}
+
+static void SendAck(struct RudpConn *conn) {
+    char buf[MAX_ACK];
+    unsigned int blocks = 0;
+    uint32_t limit = conn->rcv_read + conn->opts.window;
+
+    // Блоки SACK - непрерывные куски, полученные после дыры
+    for (uint32_t seq = conn->rcv_next + 1; SeqBefore(seq, limit) && blocks < RUDP_MAX_SACK;) {
+        if (!conn->rcv[seq % conn->opts.window].present) {
+            seq++;
+            continue;
+        }
+        uint32_t begin = seq;
+        while (SeqBefore(seq, limit) && conn->rcv[seq % conn->opts.window].present) seq++;
+        PutU32(buf + ACK_SIZE + 8 * blocks, begin);
+        PutU32(buf + ACK_SIZE + 8 * blocks + 4, seq);
+        blocks++;
+    }
+
+    buf[0] = PACKET_ACK;
+    buf[1] = 0;
+    PutU16(buf + 2, blocks);
+    PutU32(buf + 4, conn->rcv_next);
+    PutU32(buf + HEADER_SIZE, limit);
+    RawSend(conn, buf, ACK_SIZE + 8 * blocks);
+    conn->stats.acks_sent++;
+    conn->ack_pending = false;
+}
+
+static void OnData(struct RudpConn *conn, uint32_t seq, uint8_t flags, const char *data,
+                   uint16_t len) {
+    conn->ack_pending = true;
+    // Уже полученное или за пределами окна: только повторить подтверждение
+    if (SeqBefore(seq, conn->rcv_next) || seq - conn->rcv_read >= conn->opts.window) {
+        conn->stats.duplicates++;
+        return;
+    }
+    struct RecvSlot *slot = &conn->rcv[seq % conn->opts.window];
+    if (slot->present) {
+        conn->stats.duplicates++;
+        return;
+    }
+    slot->present = true;
+    slot->flags = flags;
+    slot->len = len;
+    memcpy(slot->data, data, len);
+    conn->stats.data_received++;
+
+    while (conn->rcv_next - conn->rcv_read < conn->opts.window &&
+           conn->rcv[conn->rcv_next % conn->opts.window].present) {
+        conn->rcv_next++;
+    }
+}
+
+static void ResetRto(struct RudpConn *conn) {
+    uint64_t var = 4 * conn->rttvar;
+    conn->rto = conn->srtt + (var > RTO_GRANULARITY_NS ? var : RTO_GRANULARITY_NS);
+    if (conn->rto < MIN_RTO_NS) conn->rto = MIN_RTO_NS;
+    if (conn->rto > MAX_RTO_NS) conn->rto = MAX_RTO_NS;
+}
+
+// RFC 6298
+static void UpdateRtt(struct RudpConn *conn, uint64_t sample) {
+    if (!conn->has_rtt) {
+        conn->srtt = sample;
+        conn->rttvar = sample / 2;
+        conn->has_rtt = true;
+    } else {
+        uint64_t diff = conn->srtt > sample ? conn->srtt - sample : sample - conn->srtt;
+        conn->rttvar = (3 * conn->rttvar + diff) / 4;
+        conn->srtt = (7 * conn->srtt + sample) / 8;
+    }
+    ResetRto(conn);
+}
+
+static void OnAck(struct RudpConn *conn, uint32_t cum, uint32_t limit, const char *blocks,
+                  uint16_t count, uint64_t now) {
+    uint64_t sample = 0;
+    bool has_sample = false;
+
+    if (SeqBefore(conn->snd_limit, limit)) conn->snd_limit = limit;
+
+    if (SeqBefore(conn->snd_base, cum) && !SeqBefore(conn->snd_next, cum)) {
+        // Поток сдвинулся - откат RTO снимается, как в Linux. Иначе при
+        // большом окне, где все датаграммы уже повторялись, по Карну не
+        // будет ни одного замера и RTO застрянет на максимуме
+        if (conn->has_rtt) ResetRto(conn);
+        for (; conn->snd_base != cum; conn->snd_base++) {
+            struct SendSlot *slot = &conn->snd[conn->snd_base % conn->opts.window];
+            if (!slot->retransmitted && !slot->sacked) {
+                sample = now - slot->sent_at;
+                has_sample = true;
+            }
+        }
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t begin = GetU32(blocks + 8 * i);
+        uint32_t end = GetU32(blocks + 8 * i + 4);
+        if (SeqBefore(begin, conn->snd_base)) begin = conn->snd_base;
+        if (SeqBefore(conn->snd_next, end)) end = conn->snd_next;
+        for (uint32_t seq = begin; SeqBefore(seq, end); seq++) {
+            struct SendSlot *slot = &conn->snd[seq % conn->opts.window];
+            if (slot->sacked) continue;
+            slot->sacked = true;
+            if (!slot->retransmitted) {
+                sample = now - slot->sent_at;
+                has_sample = true;
+            }
+        }
+    }
+    if (has_sample) UpdateRtt(conn, sample);
+
+    // Дыра, над которой подтверждено DUP_THRESH датаграмм, считается потерей
+    // и повторяется сразу, не дожидаясь RTO. Быстрый повтор - один раз на
+    // датаграмму: если потерян и он, дальше работает таймер
+    unsigned int sacked_above = 0;
+    for (uint32_t seq = conn->snd_next; seq != conn->snd_base;) {
+        seq--;
+        struct SendSlot *slot = &conn->snd[seq % conn->opts.window];
+        if (slot->sacked) {
+            sacked_above++;
+        } else if (sacked_above >= DUP_THRESH && !slot->retransmitted) {
+            Retransmit(conn, slot, now);
+            conn->stats.fast_retransmits++;
+        }
+    }
+}
+
+static void HandleDatagram(struct RudpConn *conn, const char *buf, size_t len, uint64_t now) {
+    if (len < HEADER_SIZE) return;
+    uint16_t count = GetU16(buf + 2);
+    uint32_t seq = GetU32(buf + 4);
+
+    if (buf[0] == PACKET_DATA && count <= RUDP_MAX_PAYLOAD && len == HEADER_SIZE + count) {
+        OnData(conn, seq, buf[1], buf + HEADER_SIZE, count);
+    } else if (buf[0] == PACKET_ACK && count <= RUDP_MAX_SACK &&
+               len == ACK_SIZE + 8 * (size_t)count) {
+        OnAck(conn, seq, GetU32(buf + HEADER_SIZE), buf + ACK_SIZE, count, now);
+    }
+}
+
+// Повтор по таймауту; при срабатывании RTO удваивается (откат)
+static void CheckTimers(struct RudpConn *conn, uint64_t now) {
+    if (conn->held_len > 0 && now - conn->held_at >= REORDER_DELAY_NS) FlushHeld(conn);
+
+    bool expired = false;
+    for (uint32_t seq = conn->snd_base; seq != conn->snd_next; seq++) {
+        struct SendSlot *slot = &conn->snd[seq % conn->opts.window];
+        if (slot->sacked || now - slot->sent_at < conn->rto) continue;
+        Retransmit(conn, slot, now);
+        conn->stats.retransmits++;
+        expired = true;
+    }
+    if (expired) {
+        conn->stats.timeouts++;
+        conn->rto = conn->rto * 2 < MAX_RTO_NS ? conn->rto * 2 : MAX_RTO_NS;
+    }
+}
+
+// Ближайший момент, когда нужно проснуться, или 0
+static uint64_t NextDeadline(const struct RudpConn *conn) {
+    uint64_t deadline = 0;
+    if (conn->held_len > 0) deadline = conn->held_at + REORDER_DELAY_NS;
+    for (uint32_t seq = conn->snd_base; seq != conn->snd_next; seq++) {
+        const struct SendSlot *slot = &conn->snd[seq % conn->opts.window];
+        if (slot->sacked) continue;
+        uint64_t t = slot->sent_at + conn->rto;
+        if (deadline == 0 || t < deadline) deadline = t;
+    }
+    return deadline;
+}
+
+// Один шаг: ждет датаграмм не дольше timeout_ns (0 - не ждать, UINT64_MAX -
+// до ближайшего таймера), разбирает все пришедшие и обслуживает таймеры
+static int Pump(struct RudpConn *conn, uint64_t timeout_ns) {
+    uint64_t now = NowNs();
+    uint64_t deadline = NextDeadline(conn);
+    if (deadline != 0 && (timeout_ns == UINT64_MAX || deadline - now < timeout_ns)) {
+        timeout_ns = deadline > now ? deadline - now : 0;
+    }
+    int timeout_ms = timeout_ns == UINT64_MAX ? -1 : (int)((timeout_ns + 999999) / 1000000);
+
+    struct pollfd pfd = {.fd = conn->fd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) < 0 && errno != EINTR) return -1;
+
+    char buf[MAX_DATAGRAM];
+    while (1) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t n = recvfrom(conn->fd, buf, sizeof(buf), MSG_DONTWAIT,
+                             (struct sockaddr *)&from, &from_len);
+        if (n < 0) {
+            if (errno == EINTR || errno == ECONNREFUSED) continue;
+            break;
+        }
+        if (!conn->has_peer) {
+            // Собеседник - тот, кто начал поток, а не запоздавший повтор
+            // от предыдущего клиента
+            if (n < HEADER_SIZE || buf[0] != PACKET_DATA || GetU32(buf + 4) != 0) continue;
+            conn->peer = from;
+            conn->has_peer = true;
+        } else if (from.sin_addr.s_addr != conn->peer.sin_addr.s_addr ||
+                   from.sin_port != conn->peer.sin_port) {
+            continue;
+        }
+        conn->last_heard = NowNs();
+        HandleDatagram(conn, buf, n, conn->last_heard);
+    }
+
+    if (conn->ack_pending) SendAck(conn);
+    CheckTimers(conn, NowNs());
+    if (conn->error) {
+        errno = conn->error;
+        return -1;
+    }
+    return 0;
+}
+
+static int Enqueue(struct RudpConn *conn, const char *data, uint16_t len, uint8_t flags) {
+    if (!conn->has_peer) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    // Ждем места в своем окне и в окне получателя. Если в полете ничего
+    // нет, следующая датаграмма уходит и так: она же проверяет, не
+    // освободилось ли окно, подтверждение которого могло потеряться
+    while (conn->snd_next - conn->snd_base >= conn->opts.window ||
+           (!SeqBefore(conn->snd_next, conn->snd_limit) && conn->snd_base != conn->snd_next)) {
+        if (Pump(conn, UINT64_MAX) < 0) return -1;
+    }
+    struct SendSlot *slot = &conn->snd[conn->snd_next % conn->opts.window];
+    slot->seq = conn->snd_next++;
+    slot->len = len;
+    slot->flags = flags;
+    slot->sacked = false;
+    slot->retransmitted = false;
+    slot->retries = 0;
+    if (len > 0) memcpy(slot->data, data, len);
+    TransmitSlot(conn, slot, NowNs());
+    // Забираем подтверждения сразу, иначе они копятся в сокете и портят RTT
+    return Pump(conn, 0);
+}
+
+struct RudpConn *RudpCreate(int sockfd, const struct sockaddr_in *peer,
+                            const struct RudpOptions *opts) {
+    if (opts->window == 0 || opts->window > RUDP_MAX_WINDOW) {
+        errno = EINVAL;
+        return NULL;
+    }
+    struct RudpConn *conn = calloc(1, sizeof(struct RudpConn));
+    if (conn == NULL) return NULL;
+    conn->snd = calloc(opts->window, sizeof(struct SendSlot));
+    conn->rcv = calloc(opts->window, sizeof(struct RecvSlot));
+    if (conn->snd == NULL || conn->rcv == NULL) {
+        RudpDestroy(conn);
+        return NULL;
+    }
+    conn->fd = sockfd;
+    conn->opts = *opts;
+    conn->rng = opts->seed ? opts->seed : 0x9E3779B97F4A7C15ULL ^ NowNs();
+    conn->rto = INITIAL_RTO_NS;
+    conn->last_heard = NowNs();
+    // Окно получателя неизвестно до первого ACK
+    conn->snd_limit = opts->window < RUDP_DEFAULT_WINDOW ? opts->window : RUDP_DEFAULT_WINDOW;
+    if (peer != NULL) {
+        conn->peer = *peer;
+        conn->has_peer = true;
+    }
+    return conn;
+}
+
+int RudpSend(struct RudpConn *conn, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        uint16_t chunk = len < RUDP_MAX_PAYLOAD ? len : RUDP_MAX_PAYLOAD;
+        if (Enqueue(conn, p, chunk, 0) < 0) return -1;
+        p += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+ssize_t RudpRecv(struct RudpConn *conn, void *buf, size_t len) {
+    while (1) {
+        if (conn->rcv_read != conn->rcv_next) {
+            struct RecvSlot *slot = &conn->rcv[conn->rcv_read % conn->opts.window];
+            if (slot->flags & FLAG_FIN) {
+                conn->fin_received = true;
+                return 0;
+            }
+            size_t n = slot->len - conn->read_off;
+            if (n > len) n = len;
+            memcpy(buf, slot->data + conn->read_off, n);
+            conn->read_off += n;
+            if (conn->read_off == slot->len) {
+                slot->present = false;
+                conn->rcv_read++;
+                conn->read_off = 0;
+            }
+            return n;
+        }
+
+        // Пока собеседник неизвестен, ждем первую датаграмму сколько угодно
+        uint64_t timeout = UINT64_MAX;
+        if (conn->has_peer) {
+            uint64_t idle = NowNs() - conn->last_heard;
+            timeout = idle < IDLE_TIMEOUT_NS ? IDLE_TIMEOUT_NS - idle : 0;
+        }
+        if (Pump(conn, timeout) < 0) return -1;
+        if (conn->has_peer && conn->rcv_read == conn->rcv_next &&
+            NowNs() - conn->last_heard >= IDLE_TIMEOUT_NS) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+}
+
+int RudpKeepalive(struct RudpConn *conn) {
+    if (!conn->has_peer) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    if (NowNs() - conn->last_sent >= RUDP_KEEPALIVE_MS * 1000000ULL) SendAck(conn);
+    return Pump(conn, 0);
+}
+
+int RudpClose(struct RudpConn *conn) {
+    if (conn->fin_received) {
+        uint64_t until = NowNs() + LINGER_NS;
+        for (uint64_t now = NowNs(); now < until; now = NowNs()) {
+            if (Pump(conn, until - now) < 0) return -1;
+        }
+        FlushHeld(conn);
+        return 0;
+    }
+
+    if (Enqueue(conn, NULL, 0, FLAG_FIN) < 0) return -1;
+    while (conn->snd_base != conn->snd_next) {
+        if (Pump(conn, UINT64_MAX) < 0) return -1;
+    }
+    FlushHeld(conn);
+    return 0;
+}
+
+void RudpGetStats(const struct RudpConn *conn, struct RudpStats *stats) {
+    *stats = conn->stats;
+    stats->srtt_us = conn->srtt / 1000;
+    stats->rto_us = conn->rto / 1000;
+}
+
+void RudpDestroy(struct RudpConn *conn) {
+    if (conn == NULL) return;
+    free(conn->snd);
+    free(conn->rcv);
+    free(conn);
+}
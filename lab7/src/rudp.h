@@ -0,0 +1,70 @@
+#ifndef RUDP_H
+#define RUDP_H
+
+#include <netinet/in.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define RUDP_MAX_PAYLOAD 1200
+#define RUDP_DEFAULT_WINDOW 64
+#define RUDP_MAX_WINDOW 1024
+// Блоков SACK в одном подтверждении
+#define RUDP_MAX_SACK 16
+// Как часто молчащий отправитель должен вызывать RudpKeepalive
+#define RUDP_KEEPALIVE_MS 2000
+
+struct RudpOptions {
+    unsigned int window;  // Датаграмм в полете, не больше RUDP_MAX_WINDOW
+    // Имитация плохой сети на отправке: доля выброшенных датаграмм и доля
+    // датаграмм, придержанных до отправки следующей
+    double loss;
+    double reorder;
+    unsigned int seed;
+};
+
+struct RudpStats {
+    uint64_t data_sent;         // Датаграмм с данными, включая повторы
+    uint64_t retransmits;       // Повторы по таймауту
+    uint64_t fast_retransmits;  // Повторы по дырам в SACK
+    uint64_t timeouts;          // Срабатываний RTO
+    uint64_t acks_sent;
+    uint64_t data_received;
+    uint64_t duplicates;
+    uint64_t shim_dropped;
+    uint64_t shim_reordered;
+    uint64_t srtt_us;
+    uint64_t rto_us;
+};
+
+// Надежная доставка поверх UDP: нумерация датаграмм, скользящее окно,
+// кумулятивные подтверждения с блоками SACK, RTO по RFC 6298 с алгоритмом
+// Карна и экспоненциальным откатом. Соединение однопоточное, ввод-вывод
+// выполняется внутри вызовов RudpSend/RudpRecv/RudpClose.
+//
+// peer == NULL - адрес собеседника берется из первой пришедшей датаграммы
+struct RudpConn *RudpCreate(int sockfd, const struct sockaddr_in *peer,
+                            const struct RudpOptions *opts);
+
+// Возвращает 0, когда все данные поставлены в окно, -1 при ошибке (errno)
+int RudpSend(struct RudpConn *conn, const void *buf, size_t len);
+
+// Данные по порядку; 0 - собеседник закрыл поток, -1 - ошибка (errno).
+// ETIMEDOUT - собеседник давно молчит и, видимо, пропал
+ssize_t RudpRecv(struct RudpConn *conn, void *buf, size_t len);
+
+// Для отправителя, которому пока нечего слать: разбирает пришедшие
+// подтверждения и, если собеседнику давно ничего не уходило, шлет признак
+// жизни. Вызывается, когда сокет готов к чтению, и не реже раза в
+// RUDP_KEEPALIVE_MS - иначе получатель сочтет отправителя пропавшим
+int RudpKeepalive(struct RudpConn *conn);
+
+// Отправитель: шлет FIN и ждет подтверждения всех данных.
+// Получатель, уже увидевший FIN: некоторое время отвечает на повторы,
+// чтобы потерянное последнее подтверждение не оставило отправителя ждать
+int RudpClose(struct RudpConn *conn);
+
+void RudpGetStats(const struct RudpConn *conn, struct RudpStats *stats);
+
+void RudpDestroy(struct RudpConn *conn);
+
+#endif // RUDP_H
@@ -1,65 +1,543 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #define BUFSIZE 100
 #define SADDR struct sockaddr
+#define MAX_EVENTS 64
+#define CACHE_LINE_SIZE 64
+// Чтений с одного сокета за событие: остальные соединения не ждут
+#define READS_PER_EVENT 16
 
-int main(int argc, char *argv[]) {
-    int lfd, cfd;
-    int nread;
-    char buf[BUFSIZE];
-    struct sockaddr_in servaddr;
-    struct sockaddr_in cliaddr;
+// Куда деваются принятые данные
+enum Sink {
+    SINK_STDOUT,   // Как раньше: печать в терминал
+    SINK_DISCARD,  // Чтение и выброс
+    SINK_COUNT,    // Выброс и ежесекундная статистика
+    SINK_ECHO,     // Отправка обратно клиенту (для замеров RTT)
+};
 
-    if (argc != 2) {
-        printf("Usage: %s <port>\n", argv[0]);
-        exit(1);
+struct Options {
+    int port;
+    int threads;
+    size_t bufsize;
+    bool bufsize_set;  // --bufsize задан явно
+    enum Sink sink;
+    const char *forward_path;  // Данные клиентов уходят сюда через splice
+    bool tee;                  // И копируются в stdout (канал) через tee
+    const char *serve_path;    // Файл, отдаваемый каждому клиенту через sendfile
+};
+
+// Счетчики потока; каждый поток пишет только свои, основной читает
+struct WorkerStats {
+    uint64_t bytes;
+    uint64_t accepted;
+    int64_t active;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+// Поток со своим слушающим сокетом (SO_REUSEPORT) и своим epoll
+struct Worker {
+    pthread_t thread;
+    int lfd;
+    int epfd;
+    char *buf;
+    int pipe[2];  // Промежуточный канал для splice в режиме --forward
+    size_t splice_len;  // Сколько переносит один splice из сокета
+    struct WorkerStats stats;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct Connection {
+    int fd;
+    off_t offset;  // Сколько файла уже отдано в режиме --serve
+    // Неотправленный хвост эха: пока он есть, чтение приостановлено
+    char *pending;
+    size_t pending_len;
+    size_t pending_off;
+};
+
+static struct Options opts = {-1, 1, BUFSIZE, false, SINK_STDOUT, NULL, false, NULL};
+static int forward_fd = -1;
+// Конец уже занятой части forward_fd. Потоки резервируют в файле место под
+// свою порцию и пишут по явному смещению, иначе одновременные splice с общей
+// позицией файла перезаписывают друг друга. У канала смещения нет
+static bool forward_seekable;
+static off_t forward_offset = 0;
+static int serve_fd = -1;
+static off_t serve_size;
+
+static bool ParseSink(const char *name, enum Sink *sink) {
+    if (strcmp(name, "stdout") == 0) {
+        *sink = SINK_STDOUT;
+    } else if (strcmp(name, "discard") == 0) {
+        *sink = SINK_DISCARD;
+    } else if (strcmp(name, "count") == 0) {
+        *sink = SINK_COUNT;
+    } else if (strcmp(name, "echo") == 0) {
+        *sink = SINK_ECHO;
+    } else {
+        return false;
     }
+    return true;
+}
+
+static void Usage(const char *name) {
+    printf("Usage: %s [--threads N] [--bufsize N] [--sink stdout|discard|count|echo]\n"
+           "       [--forward PATH [--tee] | --serve FILE] <port>\n", name);
+    exit(1);
+}
 
+static int CreateListener(void) {
     const size_t kSize = sizeof(struct sockaddr_in);
-    
-    if ((lfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+    struct sockaddr_in servaddr;
+    int lfd;
+
+    if ((lfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0) {
         perror("socket");
         exit(1);
     }
 
+    // Каждый поток слушает свой сокет на том же порту, ядро само
+    // распределяет между ними входящие соединения
+    int opt = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (setsockopt(lfd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt SO_REUSEPORT");
+        exit(1);
+    }
+
     memset(&servaddr, 0, kSize);
     servaddr.sin_family = AF_INET;
     servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
-    servaddr.sin_port = htons(atoi(argv[1]));
+    servaddr.sin_port = htons(opts.port);
 
     if (bind(lfd, (SADDR *)&servaddr, kSize) < 0) {
         perror("bind");
         exit(1);
     }
 
-    if (listen(lfd, 5) < 0) {
+    if (listen(lfd, SOMAXCONN) < 0) {
         perror("listen");
         exit(1);
     }
+    return lfd;
+}
+
+static void CloseConnection(struct Worker *w, struct Connection *conn) {
+    close(conn->fd);
+    free(conn->pending);
+    free(conn);
+    __atomic_fetch_sub(&w->stats.active, 1, __ATOMIC_RELAXED);
+}
 
+static bool ServeConnection(struct Worker *w, struct Connection *conn);
+
+static void AcceptConnections(struct Worker *w) {
     while (1) {
-        unsigned int clilen = kSize;
+        int cfd = accept4(w->lfd, NULL, NULL, SOCK_NONBLOCK);
+        if (cfd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
 
-        if ((cfd = accept(lfd, (SADDR *)&cliaddr, &clilen)) < 0) {
-            perror("accept");
-            exit(1);
+        struct Connection *conn = malloc(sizeof(struct Connection));
+        if (conn == NULL) {
+            close(cfd);
+            continue;
         }
-        printf("Connection established\n");
+        // Эхо отвечает сразу: иначе Нейгл вместе с отложенным ACK клиента
+        // держит ответ до следующего запроса, и замер RTT врет
+        if (opts.sink == SINK_ECHO) {
+            int opt = 1;
+            setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        }
+        conn->fd = cfd;
+        conn->offset = 0;
+        conn->pending = NULL;
+        conn->pending_len = conn->pending_off = 0;
 
-        while ((nread = read(cfd, buf, BUFSIZE)) > 0) {
-            write(1, buf, nread);
+        // EPOLLOUT нужен, только пока файл не отдан целиком: для пустого
+        // файла сокет всегда готов к записи, и поток крутился бы впустую
+        struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = conn};
+        if (serve_fd >= 0 && serve_size > 0) ev.events |= EPOLLOUT;
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, cfd, &ev) < 0) {
+            perror("epoll_ctl");
+            close(cfd);
+            free(conn);
+            continue;
+        }
+        __atomic_fetch_add(&w->stats.accepted, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&w->stats.active, 1, __ATOMIC_RELAXED);
+        if (opts.sink == SINK_STDOUT) {
+            // Данные идут в терминал через write, поэтому буфер stdio сбрасывается сразу
+            printf("Connection established\n");
+            fflush(stdout);
         }
+        // Отдача начинается сразу, не дожидаясь первого EPOLLOUT
+        if (serve_fd >= 0 && !ServeConnection(w, conn)) CloseConnection(w, conn);
+    }
+}
 
-        if (nread == -1) {
+// false, если соединение закрыто
+static bool ReadConnection(struct Worker *w, struct Connection *conn) {
+    for (int i = 0; i < READS_PER_EVENT; i++) {
+        ssize_t nread = read(conn->fd, w->buf, opts.bufsize);
+        if (nread < 0 && errno == EINTR) continue;
+        if (nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (nread < 0) {
             perror("read");
+            return false;
+        }
+        if (nread == 0) return false;
+
+        __atomic_fetch_add(&w->stats.bytes, nread, __ATOMIC_RELAXED);
+        if (opts.sink == SINK_STDOUT && write(1, w->buf, nread) < 0) {
+            perror("write");
+        }
+    }
+    return true;
+}
+
+// Выбрасывает n байт, оставшихся в канале потока после ошибки, чтобы они
+// не попали в поток следующего соединения
+static void DiscardPipe(struct Worker *w, size_t n) {
+    while (n > 0) {
+        ssize_t got = read(w->pipe[0], w->buf, n < opts.bufsize ? n : opts.bufsize);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return;
+        n -= got;
+    }
+}
+
+// Переносит len байт из канала потока в forward_fd; при --tee сначала
+// дублирует их в stdout, тоже без копирования в пространство пользователя.
+// false при ошибке: соединение закрывается, остальные продолжают работать
+static bool DrainPipe(struct Worker *w, size_t len) {
+    while (len > 0) {
+        ssize_t chunk = len;
+        if (opts.tee) {
+            chunk = tee(w->pipe[0], 1, len, 0);
+            if (chunk < 0 && errno == EINTR) continue;
+            if (chunk <= 0) {
+                perror("tee");
+                DiscardPipe(w, len);
+                return false;
+            }
+        }
+        // tee не забирает данные из канала, их уносит splice
+        loff_t off = 0;
+        if (forward_seekable) off = __atomic_fetch_add(&forward_offset, chunk, __ATOMIC_RELAXED);
+        for (ssize_t left = chunk; left > 0;) {
+            ssize_t moved = splice(w->pipe[0], NULL, forward_fd, forward_seekable ? &off : NULL,
+                                   left, SPLICE_F_MOVE);
+            if (moved < 0 && errno == EINTR) continue;
+            if (moved <= 0) {
+                perror("splice");
+                DiscardPipe(w, len - chunk + left);
+                return false;
+            }
+            left -= moved;
+        }
+        len -= chunk;
+    }
+    return true;
+}
+
+// Режим --forward: сокет -> канал -> файл, данные не проходят через buf
+static bool ForwardConnection(struct Worker *w, struct Connection *conn) {
+    for (int i = 0; i < READS_PER_EVENT; i++) {
+        ssize_t nread = splice(conn->fd, NULL, w->pipe[1], NULL, w->splice_len,
+                               SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (nread < 0 && errno == EINTR) continue;
+        if (nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (nread < 0) {
+            perror("splice");
+            return false;
+        }
+        if (nread == 0) return false;
+
+        __atomic_fetch_add(&w->stats.bytes, nread, __ATOMIC_RELAXED);
+        if (!DrainPipe(w, nread)) return false;
+    }
+    return true;
+}
+
+// Режим --serve: файл отдается ядром прямо из page cache. После отправки
+// соединение закрывается на запись и дочитывается до EOF клиента
+static bool ServeConnection(struct Worker *w, struct Connection *conn) {
+    while (conn->offset < serve_size) {
+        ssize_t sent = sendfile(conn->fd, serve_fd, &conn->offset, serve_size - conn->offset);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (sent <= 0) {
+            if (sent < 0 && errno != EPIPE && errno != ECONNRESET) perror("sendfile");
+            return false;
+        }
+        __atomic_fetch_add(&w->stats.bytes, sent, __ATOMIC_RELAXED);
+    }
+
+    shutdown(conn->fd, SHUT_WR);
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = conn};
+    epoll_ctl(w->epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+    return true;
+}
+
+// Ждать от сокета записи или чтения: эхо не читает, пока не отправило старое
+static void WatchConnection(struct Worker *w, struct Connection *conn, uint32_t events) {
+    struct epoll_event ev = {.events = events | EPOLLRDHUP, .data.ptr = conn};
+    epoll_ctl(w->epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+// Дописывает отложенный хвост; true, если он ушел целиком
+static bool FlushPending(struct Connection *conn) {
+    while (conn->pending_off < conn->pending_len) {
+        ssize_t sent = send(conn->fd, conn->pending + conn->pending_off,
+                            conn->pending_len - conn->pending_off, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0) return false;
+        conn->pending_off += sent;
+    }
+    conn->pending_len = conn->pending_off = 0;
+    return true;
+}
+
+// Режим эха. Если клиент не успевает забирать ответы, остаток сохраняется
+// в соединении и чтение ждет EPOLLOUT - так буферы не растут без предела
+static bool EchoConnection(struct Worker *w, struct Connection *conn) {
+    if (conn->pending_len > 0) {
+        if (!FlushPending(conn)) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        WatchConnection(w, conn, EPOLLIN);
+    }
+
+    for (int i = 0; i < READS_PER_EVENT; i++) {
+        ssize_t nread = read(conn->fd, w->buf, opts.bufsize);
+        if (nread < 0 && errno == EINTR) continue;
+        if (nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (nread <= 0) return false;
+        __atomic_fetch_add(&w->stats.bytes, nread, __ATOMIC_RELAXED);
+
+        ssize_t sent = send(conn->fd, w->buf, nread, MSG_NOSIGNAL);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+        if (sent < 0) sent = 0;
+        if (sent < nread) {
+            if (conn->pending == NULL && (conn->pending = malloc(opts.bufsize)) == NULL) {
+                return false;
+            }
+            memcpy(conn->pending, w->buf + sent, nread - sent);
+            conn->pending_len = nread - sent;
+            WatchConnection(w, conn, EPOLLOUT);
+            return true;
+        }
+    }
+    return true;
+}
+
+static bool HandleConnection(struct Worker *w, struct Connection *conn) {
+    if (serve_fd >= 0 && conn->offset < serve_size) return ServeConnection(w, conn);
+    if (forward_fd >= 0) return ForwardConnection(w, conn);
+    if (opts.sink == SINK_ECHO) return EchoConnection(w, conn);
+    return ReadConnection(w, conn);
+}
+
+static void *WorkerLoop(void *arg) {
+    struct Worker *w = (struct Worker *)arg;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (1) {
+        int n = epoll_wait(w->epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            exit(1);
+        }
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) {
+                AcceptConnections(w);
+                continue;
+            }
+            struct Connection *conn = events[i].data.ptr;
+            if (!HandleConnection(w, conn)) CloseConnection(w, conn);
+        }
+    }
+    return NULL;
+}
+
+static double NowSec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Раз в секунду сводка по всем потокам
+static void ReportLoop(struct Worker *workers) {
+    uint64_t last_bytes = 0;
+    double last_time = NowSec();
+    while (1) {
+        sleep(1);
+        uint64_t bytes = 0, accepted = 0;
+        int64_t active = 0;
+        for (int i = 0; i < opts.threads; i++) {
+            bytes += __atomic_load_n(&workers[i].stats.bytes, __ATOMIC_RELAXED);
+            accepted += __atomic_load_n(&workers[i].stats.accepted, __ATOMIC_RELAXED);
+            active += __atomic_load_n(&workers[i].stats.active, __ATOMIC_RELAXED);
+        }
+        double now = NowSec();
+        printf("connections %llu active %lld bytes %llu rate %.2f MB/s\n",
+               (unsigned long long)accepted, (long long)active, (unsigned long long)bytes,
+               (bytes - last_bytes) / (now - last_time) / 1e6);
+        fflush(stdout);
+        last_bytes = bytes;
+        last_time = now;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static struct option options[] = {
+        {"threads", required_argument, 0, 't'},
+        {"bufsize", required_argument, 0, 'b'},
+        {"sink", required_argument, 0, 's'},
+        {"forward", required_argument, 0, 'f'},
+        {"tee", no_argument, 0, 'T'},
+        {"serve", required_argument, 0, 'S'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (c) {
+        case 't':
+            opts.threads = atoi(optarg);
+            break;
+        case 'b':
+            opts.bufsize = strtoul(optarg, NULL, 10);
+            opts.bufsize_set = true;
+            break;
+        case 's':
+            if (!ParseSink(optarg, &opts.sink)) Usage(argv[0]);
+            break;
+        case 'f':
+            opts.forward_path = optarg;
+            break;
+        case 'T':
+            opts.tee = true;
+            break;
+        case 'S':
+            opts.serve_path = optarg;
+            break;
+        default:
+            Usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || opts.threads <= 0 || opts.bufsize == 0 ||
+        (opts.forward_path && opts.serve_path) || (opts.tee && !opts.forward_path)) {
+        Usage(argv[0]);
+    }
+    opts.port = atoi(argv[optind]);
+
+    // Клиент, закрывший соединение посреди sendfile, или ушедший читатель
+    // канала --forward должны давать EPIPE одному соединению, а не убивать
+    // весь сервер сигналом
+    signal(SIGPIPE, SIG_IGN);
+
+    if (opts.forward_path) {
+        // splice не пишет в файлы с O_APPEND, поэтому файл перезаписывается
+        forward_fd = open(opts.forward_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (forward_fd < 0) {
+            perror(opts.forward_path);
+            exit(1);
+        }
+        struct stat st;
+        if (fstat(forward_fd, &st) < 0) {
+            perror(opts.forward_path);
+            exit(1);
+        }
+        forward_seekable = S_ISREG(st.st_mode);
+        if (opts.tee && (fstat(1, &st) < 0 || !S_ISFIFO(st.st_mode))) {
+            fprintf(stderr, "--tee requires stdout to be a pipe\n");
             exit(1);
         }
-        close(cfd);
     }
-}
\ No newline at end of file
+    if (opts.serve_path) {
+        struct stat st;
+        serve_fd = open(opts.serve_path, O_RDONLY);
+        if (serve_fd < 0 || fstat(serve_fd, &st) < 0) {
+            perror(opts.serve_path);
+            exit(1);
+        }
+        serve_size = st.st_size;
+    }
+
+    struct Worker *workers = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct Worker) * opts.threads);
+    if (workers == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    memset(workers, 0, sizeof(struct Worker) * opts.threads);
+
+    for (int i = 0; i < opts.threads; i++) {
+        struct Worker *w = &workers[i];
+        w->lfd = CreateListener();
+        w->buf = malloc(opts.bufsize);
+        if ((w->epfd = epoll_create1(0)) < 0 || w->buf == NULL) {
+            perror("epoll_create1");
+            exit(1);
+        }
+        if (forward_fd >= 0) {
+            if (pipe2(w->pipe, O_CLOEXEC) < 0) {
+                perror("pipe");
+                exit(1);
+            }
+            // Один splice переносит не больше емкости канала. Без --bufsize
+            // порция равна емкости, с ним канал по возможности расширяется
+            bool resize_failed = opts.bufsize_set && opts.bufsize > 65536 &&
+                                 fcntl(w->pipe[1], F_SETPIPE_SZ, (int)opts.bufsize) < 0;
+            int err = errno;
+            int capacity = fcntl(w->pipe[1], F_GETPIPE_SZ);
+            if (capacity < 0) {
+                perror("F_GETPIPE_SZ");
+                exit(1);
+            }
+            if (resize_failed) {
+                fprintf(stderr, "F_SETPIPE_SZ %zu: %s, pipe holds %d bytes\n", opts.bufsize,
+                        strerror(err), capacity);
+            }
+            w->splice_len = capacity;
+            if (opts.bufsize_set && opts.bufsize < (size_t)capacity) w->splice_len = opts.bufsize;
+        }
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+        epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->lfd, &ev);
+    }
+
+    for (int i = 0; i < opts.threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, WorkerLoop, &workers[i]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+
+    if (opts.sink == SINK_COUNT) ReportLoop(workers);
+    for (int i = 0; i < opts.threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    return 0;
+}
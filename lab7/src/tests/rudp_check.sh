@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# Сквозная проверка rudp: случайный файл идет через udpclient и udpserver
+# в режиме --reliable, оба конца теряют и переставляют датаграммы, а
+# принятое побайтно сравнивается с отправленным.
+#
+# Параметры задаются переменными окружения:
+#   PORT    - UDP порт сервера           (по умолчанию 20125)
+#   SIZE    - размер файла в байтах      (по умолчанию 2000000)
+#   LOSS    - доля потерянных датаграмм  (по умолчанию 0.05)
+#   REORDER - доля переставленных        (по умолчанию 0.05)
+
+PORT=${PORT:-20125}
+SIZE=${SIZE:-2000000}
+LOSS=${LOSS:-0.05}
+REORDER=${REORDER:-0.05}
+
+cd "$(dirname "$0")/.." || exit 1
+dir=$(mktemp -d) || exit 1
+server=
+
+cleanup() {
+    [ -n "$server" ] && kill "$server" 2>/dev/null
+    rm -rf "$dir"
+}
+trap cleanup EXIT
+
+head -c "$SIZE" /dev/urandom > "$dir/in"
+
+./udpserver --reliable --loss "$LOSS" --reorder "$REORDER" "$PORT" \
+    > "$dir/out" 2> "$dir/server.log" &
+server=$!
+
+# Сервер готов, когда напечатал приветствие
+for _ in $(seq 50); do
+    grep -q "SERVER starts" "$dir/server.log" && break
+    sleep 0.1
+done
+
+if ! timeout 60 ./udpclient --reliable --loss "$LOSS" --reorder "$REORDER" \
+        127.0.0.1 "$PORT" < "$dir/in" 2> "$dir/client.log"; then
+    echo "rudp: клиент завершился с ошибкой" >&2
+    cat "$dir/client.log" >&2
+    exit 1
+fi
+
+# Сводку сервер печатает, когда дочитал поток до FIN
+for _ in $(seq 100); do
+    grep -q "RECEIVED" "$dir/server.log" && break
+    sleep 0.1
+done
+
+cat "$dir/client.log" "$dir/server.log" | grep -E "SENT|RECEIVED"
+if ! cmp "$dir/in" "$dir/out"; then
+    echo "rudp: принятые данные отличаются от отправленных" >&2
+    exit 1
+fi
+echo "rudp: $SIZE bytes delivered intact (loss $LOSS, reorder $REORDER)"
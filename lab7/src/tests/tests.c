@@ -0,0 +1,126 @@
+#include <CUnit/Basic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "histogram.h"
+
+static struct Histogram hist;
+
+// Перцентиль гистограммы из одного значения
+static uint64_t Single(uint64_t value, double p) {
+    HistogramInit(&hist);
+    HistogramRecord(&hist, value);
+    return HistogramPercentile(&hist, p);
+}
+
+void testExactRange(void) {
+    // До 2 * HIST_SUB_COUNT каждое значение в своей корзине
+    HistogramInit(&hist);
+    for (uint64_t v = 0; v < 2 * HIST_SUB_COUNT; v++) HistogramRecord(&hist, v);
+    for (uint64_t v = 0; v < 2 * HIST_SUB_COUNT; v++) {
+        double p = 100.0 * (v + 1) / (2 * HIST_SUB_COUNT);
+        CU_ASSERT_EQUAL(HistogramPercentile(&hist, p), v);
+    }
+}
+
+void testBucketBoundaries(void) {
+    // 256 и 257 делят одну корзину шириной 2, 258 начинает следующую
+    HistogramInit(&hist);
+    HistogramRecord(&hist, 256);
+    HistogramRecord(&hist, 258);
+    CU_ASSERT_EQUAL(HistogramPercentile(&hist, 50), 257);
+    CU_ASSERT_EQUAL(HistogramPercentile(&hist, 100), 258);
+
+    // Степени двойки: 2^k - 1 закрывает последнюю корзину предыдущей степени
+    for (unsigned int k = 9; k < 64; k++) {
+        uint64_t edge = 1ull << k;
+        HistogramInit(&hist);
+        HistogramRecord(&hist, edge - 1);
+        HistogramRecord(&hist, edge);
+        HistogramRecord(&hist, UINT64_MAX);
+        CU_ASSERT_EQUAL(HistogramPercentile(&hist, 33), edge - 1);
+        // Верхняя граница корзины 2^k: ширина корзины 2^(k - HIST_SUB_BITS)
+        CU_ASSERT_EQUAL(HistogramPercentile(&hist, 66), edge + (edge >> HIST_SUB_BITS) - 1);
+    }
+
+    // Результат не превышает максимум, даже если корзина шире
+    CU_ASSERT_EQUAL(Single(1000, 100), 1000);
+    CU_ASSERT_EQUAL(Single(UINT64_MAX, 100), UINT64_MAX);
+    CU_ASSERT_EQUAL(Single(0, 50), 0);
+}
+
+void testRelativeError(void) {
+    // Граница корзины превышает значение меньше чем на 1/HIST_SUB_COUNT
+    for (uint64_t v = 1; v < (1ull << 40); v = v * 3 + 1) {
+        HistogramInit(&hist);
+        HistogramRecord(&hist, v);
+        HistogramRecord(&hist, UINT64_MAX);
+        uint64_t bound = HistogramPercentile(&hist, 50);
+        CU_ASSERT_TRUE(bound >= v);
+        CU_ASSERT_TRUE(bound - v < v / HIST_SUB_COUNT + 1);
+    }
+}
+
+void testPercentileRank(void) {
+    HistogramInit(&hist);
+    CU_ASSERT_EQUAL(HistogramPercentile(&hist, 50), 0);
+    for (uint64_t v = 1; v <= 100; v++) HistogramRecord(&hist, v);
+    CU_ASSERT_EQUAL(HistogramPercentile(&hist, 0.1), 1);
+    CU_ASSERT_EQUAL(HistogramPercentile(&hist, 50), 50);
+    CU_ASSERT_EQUAL(HistogramPercentile(&hist, 99), 99);
+    CU_ASSERT_EQUAL(HistogramPercentile(&hist, 100), 100);
+    CU_ASSERT_EQUAL(hist.min, 1);
+    CU_ASSERT_EQUAL(hist.max, 100);
+    CU_ASSERT_DOUBLE_EQUAL(HistogramMean(&hist), 50.5, 1e-9);
+}
+
+void testMerge(void) {
+    static struct Histogram even, odd, all;
+    HistogramInit(&even);
+    HistogramInit(&odd);
+    HistogramInit(&all);
+    for (uint64_t v = 0; v < 100000; v += 7) {
+        HistogramRecord(v % 2 ? &odd : &even, v * 131);
+        HistogramRecord(&all, v * 131);
+    }
+    HistogramMerge(&even, &odd);
+    CU_ASSERT_EQUAL(even.total, all.total);
+    CU_ASSERT_EQUAL(even.min, all.min);
+    CU_ASSERT_EQUAL(even.max, all.max);
+    double ps[] = {1, 50, 90, 99, 99.9, 100};
+    for (int i = 0; i < 6; i++) {
+        CU_ASSERT_EQUAL(HistogramPercentile(&even, ps[i]), HistogramPercentile(&all, ps[i]));
+    }
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry()) return CU_get_error();
+
+    /* add a suite to the registry */
+    pSuite = CU_add_suite("Histogram", NULL, NULL);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "exact small values", testExactRange)) ||
+        (NULL == CU_add_test(pSuite, "bucket boundaries", testBucketBoundaries)) ||
+        (NULL == CU_add_test(pSuite, "relative error", testRelativeError)) ||
+        (NULL == CU_add_test(pSuite, "percentile rank", testPercentileRank)) ||
+        (NULL == CU_add_test(pSuite, "merge", testMerge))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    /* make check должен падать на проваленных проверках */
+    unsigned int failures = CU_get_number_of_failures();
+    CU_cleanup_registry();
+    return failures > 0 ? 1 : CU_get_error();
+}
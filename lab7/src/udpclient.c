@@ -1,4 +1,7 @@
+#include <getopt.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <arpa/inet.h>
@@ -6,25 +9,112 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "rudp.h"
+
 #define BUFSIZE 1024
 #define SADDR struct sockaddr
 #define SLEN sizeof(struct sockaddr_in)
+// Чтение stdin в надежном режиме: крупнее, чтобы окно было занято
+#define RELIABLE_BUFSIZE 65536
+
+static void Usage(const char *name) {
+    printf("Usage: %s [--reliable [--window N] [--loss P] [--reorder P]] <IP address> <port>\n",
+           name);
+    exit(1);
+}
+
+// Весь stdin доставляется серверу надежно и по порядку
+static void SendReliable(int sockfd, const struct sockaddr_in *servaddr,
+                         const struct RudpOptions *ropts) {
+    static char buf[RELIABLE_BUFSIZE];
+    struct RudpConn *conn = RudpCreate(sockfd, servaddr, ropts);
+    if (conn == NULL) {
+        perror("RudpCreate");
+        exit(1);
+    }
+
+    int n;
+    unsigned long long total = 0;
+    while (1) {
+        // Пока stdin молчит, подтверждения разбираются по приходу (иначе
+        // портится RTT), а сервер время от времени узнает, что клиент жив
+        struct pollfd pfd[2] = {{.fd = 0, .events = POLLIN}, {.fd = sockfd, .events = POLLIN}};
+        int ready = poll(pfd, 2, RUDP_KEEPALIVE_MS);
+        if (ready == 0 || (ready > 0 && pfd[0].revents == 0)) {
+            if (RudpKeepalive(conn) < 0) {
+                perror("RudpKeepalive");
+                exit(1);
+            }
+            continue;
+        }
+        if ((n = read(0, buf, RELIABLE_BUFSIZE)) <= 0) break;
+        if (RudpSend(conn, buf, n) < 0) {
+            perror("RudpSend");
+            exit(1);
+        }
+        total += n;
+    }
+    if (RudpClose(conn) < 0) {
+        perror("RudpClose");
+        exit(1);
+    }
+
+    struct RudpStats stats;
+    RudpGetStats(conn, &stats);
+    fprintf(stderr,
+            "SENT %llu bytes: datagrams %llu, retransmits %llu (fast %llu), timeouts %llu, "
+            "srtt %llu us, rto %llu us, shim dropped %llu reordered %llu\n",
+            total, (unsigned long long)stats.data_sent, (unsigned long long)stats.retransmits,
+            (unsigned long long)stats.fast_retransmits, (unsigned long long)stats.timeouts,
+            (unsigned long long)stats.srtt_us, (unsigned long long)stats.rto_us,
+            (unsigned long long)stats.shim_dropped, (unsigned long long)stats.shim_reordered);
+    RudpDestroy(conn);
+}
 
 int main(int argc, char **argv) {
     int sockfd, n;
     char sendline[BUFSIZE], recvline[BUFSIZE + 1];
     struct sockaddr_in servaddr;
+    bool reliable = false;
+    struct RudpOptions ropts = {RUDP_DEFAULT_WINDOW, 0, 0, 0};
 
-    if (argc != 3) {
-        printf("Usage: %s <IP address> <port>\n", argv[0]);
-        exit(1);
+    static struct option options[] = {
+        {"reliable", no_argument, 0, 'R'},
+        {"window", required_argument, 0, 'w'},
+        {"loss", required_argument, 0, 'l'},
+        {"reorder", required_argument, 0, 'r'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (c) {
+        case 'R':
+            reliable = true;
+            break;
+        case 'w':
+            ropts.window = atoi(optarg);
+            break;
+        case 'l':
+            ropts.loss = atof(optarg);
+            break;
+        case 'r':
+            ropts.reorder = atof(optarg);
+            break;
+        default:
+            Usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 2) {
+        Usage(argv[0]);
     }
 
     memset(&servaddr, 0, sizeof(servaddr));
     servaddr.sin_family = AF_INET;
-    servaddr.sin_port = htons(atoi(argv[2]));
+    servaddr.sin_port = htons(atoi(argv[optind + 1]));
 
-    if (inet_pton(AF_INET, argv[1], &servaddr.sin_addr) < 0) {
+    if (inet_pton(AF_INET, argv[optind], &servaddr.sin_addr) < 0) {
         perror("inet_pton problem");
         exit(1);
     }
@@ -33,6 +123,12 @@ int main(int argc, char **argv) {
         exit(1);
     }
 
+    if (reliable) {
+        SendReliable(sockfd, &servaddr, &ropts);
+        close(sockfd);
+        exit(0);
+    }
+
     write(1, "Enter string\n", 13);
 
     while ((n = read(0, sendline, BUFSIZE)) > 0) {
@@ -49,4 +145,4 @@ int main(int argc, char **argv) {
         printf("REPLY FROM SERVER= %s\n", recvline);
     }
     close(sockfd);
-}
\ No newline at end of file
+}
@@ -1,58 +1,290 @@
+#define _GNU_SOURCE
 #include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "rudp.h"
+
 #define BUFSIZE 1024
 #define SADDR struct sockaddr
 #define SLEN sizeof(struct sockaddr_in)
+#define MAX_BATCH 64
+#define CACHE_LINE_SIZE 64
 
-int main(int argc, char *argv[]) {
-    int sockfd, n;
-    char mesg[BUFSIZE], ipadr[16];
+struct Options {
+    int port;
+    int threads;
+    int batch;
+    unsigned long log_every;  // 0 - не печатать запросы, 1 - печатать каждый
+    bool stats;
+    bool reliable;  // Прием потоков rudp вместо эха датаграмм
+    struct RudpOptions rudp;
+};
+
+// Счетчики потока; каждый поток пишет только свои, основной читает
+struct WorkerStats {
+    uint64_t packets;
+    uint64_t bytes;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+// Поток со своим сокетом на общем порту (SO_REUSEPORT) и своими буферами
+// на целую пачку датаграмм
+struct Worker {
+    pthread_t thread;
+    int sockfd;
+    struct WorkerStats stats;
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iovs[MAX_BATCH];
+    struct sockaddr_in addrs[MAX_BATCH];
+    char bufs[MAX_BATCH][BUFSIZE + 1];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static struct Options opts = {-1, 1, MAX_BATCH, 1, false, false, {RUDP_DEFAULT_WINDOW, 0, 0, 0}};
+
+static void Usage(const char *name) {
+    printf("Usage: %s [--threads N] [--batch N] [--log-every N] [--stats] <port>\n"
+           "       %s --reliable [--window N] [--loss P] [--reorder P] <port>\n", name, name);
+    exit(1);
+}
+
+static int CreateSocket(void) {
+    int sockfd;
     struct sockaddr_in servaddr;
-    struct sockaddr_in cliaddr;
 
-    if (argc != 2) {
-        printf("Usage: %s <port>\n", argv[0]);
+    if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("socket problem");
         exit(1);
     }
 
-    if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
-        perror("socket problem");
+    // Ядро раскладывает датаграммы по сокетам потоков по хешу адреса клиента
+    int opt = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt SO_REUSEPORT");
         exit(1);
     }
 
     memset(&servaddr, 0, SLEN);
     servaddr.sin_family = AF_INET;
     servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
-    servaddr.sin_port = htons(atoi(argv[1]));
+    servaddr.sin_port = htons(opts.port);
 
     if (bind(sockfd, (SADDR *)&servaddr, SLEN) < 0) {
         perror("bind problem");
         exit(1);
     }
-    printf("SERVER starts...\n");
+    return sockfd;
+}
+
+static void LogRequest(struct Worker *w, int i) {
+    char ipadr[16];
+    w->bufs[i][w->msgs[i].msg_len] = 0;
+    printf("REQUEST %s FROM %s : %d\n", w->bufs[i],
+           inet_ntop(AF_INET, (void *)&w->addrs[i].sin_addr.s_addr, ipadr, 16),
+           ntohs(w->addrs[i].sin_port));
+}
+
+static void *WorkerLoop(void *arg) {
+    struct Worker *w = (struct Worker *)arg;
 
+    for (int i = 0; i < opts.batch; i++) {
+        w->msgs[i].msg_hdr.msg_iov = &w->iovs[i];
+        w->msgs[i].msg_hdr.msg_iovlen = 1;
+        w->msgs[i].msg_hdr.msg_name = &w->addrs[i];
+    }
+
+    uint64_t seen = 0;
     while (1) {
-        unsigned int len = SLEN;
+        for (int i = 0; i < opts.batch; i++) {
+            w->iovs[i].iov_base = w->bufs[i];
+            w->iovs[i].iov_len = BUFSIZE;
+            w->msgs[i].msg_hdr.msg_namelen = SLEN;
+        }
 
-        if ((n = recvfrom(sockfd, mesg, BUFSIZE, 0, (SADDR *)&cliaddr, &len)) < 0) {
-            perror("recvfrom");
+        // Ждем первую датаграмму, остальные забираем, только если уже пришли
+        int n = recvmmsg(w->sockfd, w->msgs, opts.batch, MSG_WAITFORONE, NULL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("recvmmsg");
             exit(1);
         }
-        mesg[n] = 0;
 
-        printf("REQUEST %s FROM %s : %d\n", mesg,
-               inet_ntop(AF_INET, (void *)&cliaddr.sin_addr.s_addr, ipadr, 16),
-               ntohs(cliaddr.sin_port));
+        uint64_t bytes = 0;
+        for (int i = 0; i < n; i++) {
+            // Ответ - та же датаграмма тому же адресу
+            w->iovs[i].iov_len = w->msgs[i].msg_len;
+            bytes += w->msgs[i].msg_len;
+            if (opts.log_every && ++seen % opts.log_every == 0) LogRequest(w, i);
+        }
 
-        if (sendto(sockfd, mesg, n, 0, (SADDR *)&cliaddr, len) < 0) {
-            perror("sendto");
+        for (int sent = 0; sent < n;) {
+            int m = sendmmsg(w->sockfd, w->msgs + sent, n - sent, 0);
+            if (m < 0) {
+                if (errno == EINTR) continue;
+                perror("sendmmsg");
+                exit(1);
+            }
+            sent += m;
+        }
+
+        __atomic_fetch_add(&w->stats.packets, n, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&w->stats.bytes, bytes, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Надежный режим: клиенты обслуживаются по очереди, данные каждого
+// выводятся по порядку в stdout, сводка - в stderr
+static void ServeReliable(int sockfd) {
+    char buf[RUDP_MAX_PAYLOAD];
+    while (1) {
+        struct RudpConn *conn = RudpCreate(sockfd, NULL, &opts.rudp);
+        if (conn == NULL) {
+            perror("RudpCreate");
             exit(1);
         }
+
+        ssize_t n;
+        unsigned long long total = 0;
+        while ((n = RudpRecv(conn, buf, sizeof(buf))) > 0) {
+            if (write(1, buf, n) < 0) perror("write");
+            total += n;
+        }
+        // Пропавший клиент не держит сервер: соединение бросается, и
+        // обслуживается следующий
+        if (n < 0 && errno == ETIMEDOUT) {
+            fprintf(stderr, "Peer went silent, dropping connection\n");
+        } else if (n < 0 || RudpClose(conn) < 0) {
+            perror("rudp");
+        }
+
+        struct RudpStats stats;
+        RudpGetStats(conn, &stats);
+        fprintf(stderr,
+                "RECEIVED %llu bytes: datagrams %llu, duplicates %llu, acks %llu, "
+                "shim dropped %llu reordered %llu\n",
+                total, (unsigned long long)stats.data_received,
+                (unsigned long long)stats.duplicates, (unsigned long long)stats.acks_sent,
+                (unsigned long long)stats.shim_dropped, (unsigned long long)stats.shim_reordered);
+        RudpDestroy(conn);
+    }
+}
+
+static double NowSec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Раз в секунду сводка по всем потокам
+static void ReportLoop(struct Worker *workers) {
+    uint64_t last_packets = 0;
+    double last_time = NowSec();
+    while (1) {
+        sleep(1);
+        uint64_t packets = 0, bytes = 0;
+        for (int i = 0; i < opts.threads; i++) {
+            packets += __atomic_load_n(&workers[i].stats.packets, __ATOMIC_RELAXED);
+            bytes += __atomic_load_n(&workers[i].stats.bytes, __ATOMIC_RELAXED);
+        }
+        double now = NowSec();
+        printf("packets %llu bytes %llu rate %.0f pps\n", (unsigned long long)packets,
+               (unsigned long long)bytes, (packets - last_packets) / (now - last_time));
+        fflush(stdout);
+        last_packets = packets;
+        last_time = now;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static struct option options[] = {
+        {"threads", required_argument, 0, 't'},
+        {"batch", required_argument, 0, 'b'},
+        {"log-every", required_argument, 0, 'l'},
+        {"stats", no_argument, 0, 's'},
+        {"reliable", no_argument, 0, 'R'},
+        {"window", required_argument, 0, 'w'},
+        {"loss", required_argument, 0, 'L'},
+        {"reorder", required_argument, 0, 'r'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (c) {
+        case 't':
+            opts.threads = atoi(optarg);
+            break;
+        case 'b':
+            opts.batch = atoi(optarg);
+            break;
+        case 'l':
+            opts.log_every = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            opts.stats = true;
+            break;
+        case 'R':
+            opts.reliable = true;
+            break;
+        case 'w':
+            opts.rudp.window = atoi(optarg);
+            break;
+        case 'L':
+            opts.rudp.loss = atof(optarg);
+            break;
+        case 'r':
+            opts.rudp.reorder = atof(optarg);
+            break;
+        default:
+            Usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || opts.threads <= 0 || opts.batch <= 0 || opts.batch > MAX_BATCH) {
+        Usage(argv[0]);
+    }
+    opts.port = atoi(argv[optind]);
+
+    if (opts.reliable) {
+        if (opts.threads != 1) Usage(argv[0]);
+        int sockfd = CreateSocket();
+        fprintf(stderr, "SERVER starts...\n");
+        ServeReliable(sockfd);
+    }
+
+    struct Worker *workers = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct Worker) * opts.threads);
+    if (workers == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    memset(workers, 0, sizeof(struct Worker) * opts.threads);
+
+    for (int i = 0; i < opts.threads; i++) {
+        workers[i].sockfd = CreateSocket();
+    }
+    printf("SERVER starts...\n");
+    fflush(stdout);
+
+    for (int i = 0; i < opts.threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, WorkerLoop, &workers[i]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+
+    if (opts.stats) ReportLoop(workers);
+    for (int i = 0; i < opts.threads; i++) {
+        pthread_join(workers[i].thread, NULL);
     }
-}
\ No newline at end of file
+    return 0;
+}